@@ -1,45 +1,71 @@
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
+#include <map>
 #include <string>
 #include <thread>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "VCL2/instrset.h"
 #include "vsTTempSmooth.h"
 
 template <bool pfclip, bool fp>
-template <typename T, bool useDiff>
-void TTempSmooth<pfclip, fp>::filterI(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept
+template <typename T, bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterI(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept
 {
-    int src_stride[15]{};
-    int pf_stride[15]{};
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
+    int pf_stride[diameter]{};
     const size_t stride{ dst->GetPitch(plane) / sizeof(T) };
     const size_t width{ dst->GetRowSize(plane) / sizeof(T) };
-    const int height{ dst->GetHeight(plane) };
-    const T* srcp[15]{}, * pfp[15]{};
+    const int height{ y1 - y0 };
+    const T* srcp[diameter]{}, * pfp[diameter]{};
 
-    for (int i{ 0 }; i < _diameter; ++i)
+    for (int i{ 0 }; i < diameter; ++i)
     {
         src_stride[i] = src[i]->GetPitch(plane) / sizeof(T);
         pf_stride[i] = pf[i]->GetPitch(plane) / sizeof(T);
-        srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane));
-        pfp[i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(plane));
+        srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane)) + y0 * src_stride[i];
+        pfp[i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(plane)) + y0 * pf_stride[i];
     }
 
-    T* __restrict dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) };
+    T* __restrict dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) + y0 * stride };
+
+    if (guide)
+        guide += y0 * guide_stride(width);
 
     const int l{ plane >> 1 };
-    const int thresh{ _thresh[l] << _shift };
+    const int shift{ (std::is_same_v<T, uint8_t>) ? 0 : _shift };
+    const int thresh{ _thresh[l] << shift };
     const float* const weightSaved{ _weight[l].data() };
 
     for (int y{ 0 }; y < height; ++y)
     {
         for (int x{ 0 }; x < width; ++x)
         {
-            const int c{ static_cast<int>(pfp[_maxr][x]) };
+            const int c{ static_cast<int>(pfp[maxr][x]) };
             float weights{ _cw };
-            float sum{ srcp[_maxr][x] * _cw };
+            float sum{ ((pfclip) ? srcp[maxr][x] : c) * _cw };
+            uint32_t accepted{ 0 };
+            int bucket{ 0 };
 
-            int frameIndex{ _maxr - 1 };
+            int frameIndex{ maxr - 1 };
 
             if (frameIndex > fromFrame)
             {
@@ -48,35 +74,44 @@ void TTempSmooth<pfclip, fp>::filterI(PVideoFrame src[15], PVideoFrame pf[15], P
 
                 if (diff < thresh)
                 {
-                    float weight{ weightSaved[useDiff ? diff >> _shift : frameIndex] };
+                    float weight{ weightSaved[useDiff ? diff >> shift : frameIndex] };
                     weights += weight;
-                    sum += srcp[frameIndex][x] * weight;
+                    sum += ((pfclip) ? srcp[frameIndex][x] : t1) * weight;
+                    accepted |= 1 << frameIndex;
+                    bucket = std::max(bucket, diff >> shift);
 
                     --frameIndex;
                     int v{ 256 };
 
-                    while (frameIndex > fromFrame)
+                    if constexpr (maxr > 1)
                     {
-                        const int t2{ t1 };
-                        t1 = pfp[frameIndex][x];
-                        diff = std::abs(c - t1);
-
-                        if (diff < thresh && std::abs(t1 - t2) < thresh)
+                        while (frameIndex > fromFrame)
                         {
-                            weight = weightSaved[useDiff ? (diff >> _shift) + v : frameIndex];
-                            weights += weight;
-                            sum += srcp[frameIndex][x] * weight;
-
-                            --frameIndex;
-                            v += 256;
+                            // t2 is the previous step's t1, so the continuity check needs no extra load
+                            // (a cached per-pair mask plane would add one instead of saving one)
+                            const int t2{ t1 };
+                            t1 = pfp[frameIndex][x];
+                            diff = std::abs(c - t1);
+
+                            if (diff < thresh && std::abs(t1 - t2) < thresh)
+                            {
+                                weight = weightSaved[useDiff ? (diff >> shift) + v : frameIndex];
+                                weights += weight;
+                                sum += ((pfclip) ? srcp[frameIndex][x] : t1) * weight;
+                                accepted |= 1 << frameIndex;
+                                bucket = std::max(bucket, diff >> shift);
+
+                                --frameIndex;
+                                v += 256;
+                            }
+                            else
+                                break;
                         }
-                        else
-                            break;
                     }
                 }
             }
 
-            frameIndex = _maxr + 1;
+            frameIndex = maxr + 1;
 
             if (frameIndex < toFrame)
             {
@@ -85,69 +120,86 @@ void TTempSmooth<pfclip, fp>::filterI(PVideoFrame src[15], PVideoFrame pf[15], P
 
                 if (diff < thresh)
                 {
-                    float weight{ weightSaved[useDiff ? diff >> _shift : frameIndex] };
+                    float weight{ weightSaved[useDiff ? diff >> shift : frameIndex] };
                     weights += weight;
-                    sum += srcp[frameIndex][x] * weight;
+                    sum += ((pfclip) ? srcp[frameIndex][x] : t1) * weight;
+                    accepted |= 1 << frameIndex;
+                    bucket = std::max(bucket, diff >> shift);
 
                     ++frameIndex;
                     int v{ 256 };
 
-                    while (frameIndex < toFrame)
+                    if constexpr (maxr > 1)
                     {
-                        const int t2{ t1 };
-                        t1 = pfp[frameIndex][x];
-                        diff = std::abs(c - t1);
-
-                        if (diff < thresh && std::abs(t1 - t2) < thresh)
+                        while (frameIndex < toFrame)
                         {
-                            weight = weightSaved[useDiff ? (diff >> _shift) + v : frameIndex];
-                            weights += weight;
-                            sum += srcp[frameIndex][x] * weight;
-
-                            ++frameIndex;
-                            v += 256;
+                            const int t2{ t1 };
+                            t1 = pfp[frameIndex][x];
+                            diff = std::abs(c - t1);
+
+                            if (diff < thresh && std::abs(t1 - t2) < thresh)
+                            {
+                                weight = weightSaved[useDiff ? (diff >> shift) + v : frameIndex];
+                                weights += weight;
+                                sum += ((pfclip) ? srcp[frameIndex][x] : t1) * weight;
+                                accepted |= 1 << frameIndex;
+                                bucket = std::max(bucket, diff >> shift);
+
+                                ++frameIndex;
+                                v += 256;
+                            }
+                            else
+                                break;
                         }
-                        else
-                            break;
                     }
                 }
             }
 
             if constexpr (fp)
-                dstp[x] = static_cast<T>(srcp[_maxr][x] * (1.f - weights) + sum + 0.5f);
+                dstp[x] = static_cast<T>(((pfclip) ? srcp[maxr][x] : c) * (1.f - weights) + sum + 0.5f);
             else
                 dstp[x] = static_cast<T>(sum / weights + 0.5f);
+
+            if (guide)
+                guide[x] = accepted | (bucket << 16);
         }
 
-        for (int i{ 0 }; i < _diameter; ++i)
+        for (int i{ 0 }; i < diameter; ++i)
         {
             srcp[i] += src_stride[i];
             pfp[i] += pf_stride[i];
         }
 
         dstp += stride;
+
+        if (guide)
+            guide += guide_stride(width);
     }
 }
 
 template <bool pfclip, bool fp>
-template <bool useDiff>
-void TTempSmooth<pfclip, fp>::filterF(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept
+template <bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterF(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept
 {
-    int src_stride[15]{};
-    int pf_stride[15]{};
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
+    int pf_stride[diameter]{};
     const int stride{ dst->GetPitch(plane) / 4 };
     const int width{ dst->GetRowSize(plane) / 4 };
-    const int height{ dst->GetHeight(plane) };
-    const float* srcp[15]{}, * pfp[15]{};
-    for (int i{ 0 }; i < _diameter; ++i)
+    const int height{ y1 - y0 };
+    const float* srcp[diameter]{}, * pfp[diameter]{};
+    for (int i{ 0 }; i < diameter; ++i)
     {
         src_stride[i] = src[i]->GetPitch(plane) / 4;
         pf_stride[i] = pf[i]->GetPitch(plane) / 4;
-        srcp[i] = reinterpret_cast<const float*>(src[i]->GetReadPtr(plane));
-        pfp[i] = reinterpret_cast<const float*>(pf[i]->GetReadPtr(plane));
+        srcp[i] = reinterpret_cast<const float*>(src[i]->GetReadPtr(plane)) + y0 * src_stride[i];
+        pfp[i] = reinterpret_cast<const float*>(pf[i]->GetReadPtr(plane)) + y0 * pf_stride[i];
     }
 
-    float* __restrict dstp{ reinterpret_cast<float*>(dst->GetWritePtr(plane)) };
+    float* __restrict dstp{ reinterpret_cast<float*>(dst->GetWritePtr(plane)) + y0 * stride };
+
+    if (guide)
+        guide += y0 * guide_stride(width);
 
     const int l{ plane >> 1 };
     const float thresh{ _threshF[l] };
@@ -157,11 +209,13 @@ void TTempSmooth<pfclip, fp>::filterF(PVideoFrame src[15], PVideoFrame pf[15], P
     {
         for (int x{ 0 }; x < width; ++x)
         {
-            const float c{ pfp[_maxr][x] };
+            const float c{ pfp[maxr][x] };
             float weights{ _cw };
-            float sum{ srcp[_maxr][x] * _cw };
+            float sum{ ((pfclip) ? srcp[maxr][x] : c) * _cw };
+            uint32_t accepted{ 0 };
+            int bucket{ 0 };
 
-            int frameIndex{ _maxr - 1 };
+            int frameIndex{ maxr - 1 };
 
             if (frameIndex > fromFrame)
             {
@@ -172,33 +226,40 @@ void TTempSmooth<pfclip, fp>::filterF(PVideoFrame src[15], PVideoFrame pf[15], P
                 {
                     float weight{ weightSaved[useDiff ? static_cast<int>(diff * 255.f) : frameIndex] };
                     weights += weight;
-                    sum += srcp[frameIndex][x] * weight;
+                    sum += ((pfclip) ? srcp[frameIndex][x] : t1) * weight;
+                    accepted |= 1 << frameIndex;
+                    bucket = std::max(bucket, static_cast<int>(diff * 255.f));
 
                     --frameIndex;
                     int v{ 256 };
 
-                    while (frameIndex > fromFrame)
+                    if constexpr (maxr > 1)
                     {
-                        const float t2{ t1 };
-                        t1 = pfp[frameIndex][x];
-                        diff = std::min(std::abs(c - t1), 1.f);
-
-                        if (diff < thresh && std::min(std::abs(t1 - t2), 1.f) < thresh)
+                        while (frameIndex > fromFrame)
                         {
-                            weight = weightSaved[useDiff ? static_cast<int>(diff * 255.f) + v : frameIndex];
-                            weights += weight;
-                            sum += srcp[frameIndex][x] * weight;
-
-                            --frameIndex;
-                            v += 256;
+                            const float t2{ t1 };
+                            t1 = pfp[frameIndex][x];
+                            diff = std::min(std::abs(c - t1), 1.f);
+
+                            if (diff < thresh && std::min(std::abs(t1 - t2), 1.f) < thresh)
+                            {
+                                weight = weightSaved[useDiff ? static_cast<int>(diff * 255.f) + v : frameIndex];
+                                weights += weight;
+                                sum += ((pfclip) ? srcp[frameIndex][x] : t1) * weight;
+                                accepted |= 1 << frameIndex;
+                                bucket = std::max(bucket, static_cast<int>(diff * 255.f));
+
+                                --frameIndex;
+                                v += 256;
+                            }
+                            else
+                                break;
                         }
-                        else
-                            break;
                     }
                 }
             }
 
-            frameIndex = _maxr + 1;
+            frameIndex = maxr + 1;
 
             if (frameIndex < toFrame)
             {
@@ -209,51 +270,334 @@ void TTempSmooth<pfclip, fp>::filterF(PVideoFrame src[15], PVideoFrame pf[15], P
                 {
                     float weight{ weightSaved[useDiff ? static_cast<int>(diff * 255.f) : frameIndex] };
                     weights += weight;
-                    sum += srcp[frameIndex][x] * weight;
+                    sum += ((pfclip) ? srcp[frameIndex][x] : t1) * weight;
+                    accepted |= 1 << frameIndex;
+                    bucket = std::max(bucket, static_cast<int>(diff * 255.f));
 
                     ++frameIndex;
                     int v{ 256 };
 
-                    while (frameIndex < toFrame)
+                    if constexpr (maxr > 1)
                     {
-                        const float t2{ t1 };
-                        t1 = pfp[frameIndex][x];
-                        diff = std::min(std::abs(c - t1), 1.f);
-
-                        if (diff < thresh && std::min(std::abs(t1 - t2), 1.f) < thresh)
+                        while (frameIndex < toFrame)
                         {
-                            weight = weightSaved[useDiff ? static_cast<int>(diff * 255.f) + v : frameIndex];
-                            weights += weight;
-                            sum += srcp[frameIndex][x] * weight;
-
-                            ++frameIndex;
-                            v += 256;
+                            const float t2{ t1 };
+                            t1 = pfp[frameIndex][x];
+                            diff = std::min(std::abs(c - t1), 1.f);
+
+                            if (diff < thresh && std::min(std::abs(t1 - t2), 1.f) < thresh)
+                            {
+                                weight = weightSaved[useDiff ? static_cast<int>(diff * 255.f) + v : frameIndex];
+                                weights += weight;
+                                sum += ((pfclip) ? srcp[frameIndex][x] : t1) * weight;
+                                accepted |= 1 << frameIndex;
+                                bucket = std::max(bucket, static_cast<int>(diff * 255.f));
+
+                                ++frameIndex;
+                                v += 256;
+                            }
+                            else
+                                break;
                         }
-                        else
-                            break;
                     }
                 }
             }
 
             if constexpr (fp)
-                dstp[x] = srcp[_maxr][x] * (1.f - weights) + sum;
+                dstp[x] = ((pfclip) ? srcp[maxr][x] : c) * (1.f - weights) + sum;
             else
                 dstp[x] = sum / weights;
+
+            if (guide)
+                guide[x] = accepted | (bucket << 16);
         }
 
-        for (int i{ 0 }; i < _diameter; ++i)
+        for (int i{ 0 }; i < diameter; ++i)
         {
             srcp[i] += src_stride[i];
             pfp[i] += pf_stride[i];
         }
 
         dstp += stride;
+
+        if (guide)
+            guide += guide_stride(width);
+    }
+}
+
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterUV(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int y0, const int y1) noexcept
+{
+    typedef std::conditional_t<std::is_integral_v<T>, int, float> working_t;
+
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
+    int pf_stride[diameter]{};
+    // U and V of a frame share the pitch
+    const size_t stride{ dst->GetPitch(PLANAR_U) / sizeof(T) };
+    const size_t width{ dst->GetRowSize(PLANAR_U) / sizeof(T) };
+    const int height{ y1 - y0 };
+    const T* srcp[2][diameter]{}, * pfp[2][diameter]{};
+
+    for (int i{ 0 }; i < diameter; ++i)
+    {
+        src_stride[i] = src[i]->GetPitch(PLANAR_U) / sizeof(T);
+        pf_stride[i] = pf[i]->GetPitch(PLANAR_U) / sizeof(T);
+        srcp[0][i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(PLANAR_U)) + y0 * src_stride[i];
+        srcp[1][i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(PLANAR_V)) + y0 * src_stride[i];
+        pfp[0][i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(PLANAR_U)) + y0 * pf_stride[i];
+        pfp[1][i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(PLANAR_V)) + y0 * pf_stride[i];
+    }
+
+    T* __restrict dstp[2]{ reinterpret_cast<T*>(dst->GetWritePtr(PLANAR_U)) + y0 * stride, reinterpret_cast<T*>(dst->GetWritePtr(PLANAR_V)) + y0 * stride };
+
+    const int shift{ (std::is_same_v<T, uint8_t>) ? 0 : _shift };
+    const working_t thresh[2]{ static_cast<working_t>((std::is_integral_v<T>) ? (_thresh[1] << shift) : _threshF[1]), static_cast<working_t>((std::is_integral_v<T>) ? (_thresh[2] << shift) : _threshF[2]) };
+    const float* const weightSaved[2]{ _weight[1].data(), _weight[2].data() };
+
+    // one plane's chains of a sample, like filterI/filterF; inlined twice per sample so the U and V chains overlap
+    const auto smooth = [&](const int p, const size_t x) noexcept
+    {
+        const working_t c{ static_cast<working_t>(pfp[p][maxr][x]) };
+        float weights{ _cw };
+        float sum{ ((pfclip) ? srcp[p][maxr][x] : c) * _cw };
+
+        for (int dir{ -1 }; dir <= 1; dir += 2)
+        {
+            // the first step's continuity check against the center is its difference check
+            working_t t2{ c };
+            int v{ 0 };
+
+            for (int frameIndex{ maxr + dir }; (dir < 0) ? frameIndex > fromFrame : frameIndex < toFrame; frameIndex += dir)
+            {
+                const working_t t1{ static_cast<working_t>(pfp[p][frameIndex][x]) };
+                working_t diff, step;
+
+                if constexpr (std::is_integral_v<T>)
+                {
+                    diff = std::abs(c - t1);
+                    step = std::abs(t1 - t2);
+                }
+                else
+                {
+                    diff = std::min(std::abs(c - t1), 1.f);
+                    step = std::min(std::abs(t1 - t2), 1.f);
+                }
+
+                if (diff >= thresh[p] || step >= thresh[p])
+                    break;
+
+                int index;
+
+                if constexpr (std::is_integral_v<T>)
+                    index = diff >> shift;
+                else
+                    index = static_cast<int>(diff * 255.f);
+
+                const float weight{ weightSaved[p][useDiff ? index + v : frameIndex] };
+                weights += weight;
+                sum += ((pfclip) ? srcp[p][frameIndex][x] : t1) * weight;
+
+                t2 = t1;
+                v += 256;
+            }
+        }
+
+        if constexpr (std::is_integral_v<T>)
+        {
+            if constexpr (fp)
+                dstp[p][x] = static_cast<T>(((pfclip) ? srcp[p][maxr][x] : c) * (1.f - weights) + sum + 0.5f);
+            else
+                dstp[p][x] = static_cast<T>(sum / weights + 0.5f);
+        }
+        else
+        {
+            if constexpr (fp)
+                dstp[p][x] = ((pfclip) ? srcp[p][maxr][x] : c) * (1.f - weights) + sum;
+            else
+                dstp[p][x] = sum / weights;
+        }
+    };
+
+    for (int y{ 0 }; y < height; ++y)
+    {
+        for (size_t x{ 0 }; x < width; ++x)
+        {
+            smooth(0, x);
+            smooth(1, x);
+        }
+
+        for (int i{ 0 }; i < diameter; ++i)
+        {
+            srcp[0][i] += src_stride[i];
+            srcp[1][i] += src_stride[i];
+            pfp[0][i] += pf_stride[i];
+            pfp[1][i] += pf_stride[i];
+        }
+
+        dstp[0] += stride;
+        dstp[1] += stride;
+    }
+}
+
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff>
+typename TTempSmooth<pfclip, fp>::filter_t TTempSmooth<pfclip, fp>::get_filter() const noexcept
+{
+    if constexpr (std::is_same_v<T, float>)
+    {
+        switch (_maxr)
+        {
+            case 1: return &TTempSmooth::filterF<useDiff, 1>;
+            case 2: return &TTempSmooth::filterF<useDiff, 2>;
+            case 3: return &TTempSmooth::filterF<useDiff, 3>;
+            case 4: return &TTempSmooth::filterF<useDiff, 4>;
+            case 5: return &TTempSmooth::filterF<useDiff, 5>;
+            case 6: return &TTempSmooth::filterF<useDiff, 6>;
+            default: return &TTempSmooth::filterF<useDiff, 7>;
+        }
+    }
+    else
+    {
+        switch (_maxr)
+        {
+            case 1: return &TTempSmooth::filterI<T, useDiff, 1>;
+            case 2: return &TTempSmooth::filterI<T, useDiff, 2>;
+            case 3: return &TTempSmooth::filterI<T, useDiff, 3>;
+            case 4: return &TTempSmooth::filterI<T, useDiff, 4>;
+            case 5: return &TTempSmooth::filterI<T, useDiff, 5>;
+            case 6: return &TTempSmooth::filterI<T, useDiff, 6>;
+            default: return &TTempSmooth::filterI<T, useDiff, 7>;
+        }
+    }
+}
+
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff>
+typename TTempSmooth<pfclip, fp>::filter_uv_t TTempSmooth<pfclip, fp>::get_filter_uv() const noexcept
+{
+    switch (_maxr)
+    {
+        case 1: return &TTempSmooth::filterUV<T, useDiff, 1>;
+        case 2: return &TTempSmooth::filterUV<T, useDiff, 2>;
+        case 3: return &TTempSmooth::filterUV<T, useDiff, 3>;
+        case 4: return &TTempSmooth::filterUV<T, useDiff, 4>;
+        case 5: return &TTempSmooth::filterUV<T, useDiff, 5>;
+        case 6: return &TTempSmooth::filterUV<T, useDiff, 6>;
+        default: return &TTempSmooth::filterUV<T, useDiff, 7>;
+    }
+}
+
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff>
+typename TTempSmooth<pfclip, fp>::filter_t TTempSmooth<pfclip, fp>::select_filter(const int opt) const noexcept
+{
+    switch (opt)
+    {
+        case 3: return get_filter_avx512<T, useDiff>();
+        case 2: return get_filter_avx2<T, useDiff>();
+        case 1: return get_filter_sse2<T, useDiff>();
+        default: return get_filter<T, useDiff>();
+    }
+}
+
+// frames accepted at all luma samples of a chroma sample, with the largest of their differences
+static void SubsampleGuide(const uint32_t* luma, uint32_t* chroma, const int width, const int height, const size_t luma_stride, const size_t chroma_stride, const int ssw, const int ssh) noexcept
+{
+    for (int y{ 0 }; y < height; ++y)
+    {
+        for (int x{ 0 }; x < width; ++x)
+        {
+            uint32_t accepted{ 0x7fff };
+            uint32_t bucket{ 0 };
+
+            for (int j{ 0 }; j < (1 << ssh); ++j)
+            {
+                for (int i{ 0 }; i < (1 << ssw); ++i)
+                {
+                    const uint32_t g{ luma[j * luma_stride + (x << ssw) + i] };
+                    accepted &= g;
+                    bucket = std::max(bucket, g >> 16);
+                }
+            }
+
+            chroma[x] = (accepted & 0x7fff) | (bucket << 16);
+        }
+
+        // read by the SIMD kernels
+        std::fill(chroma + width, chroma + chroma_stride, 0);
+
+        luma += luma_stride << ssh;
+        chroma += chroma_stride;
+    }
+}
+
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff>
+void TTempSmooth<pfclip, fp>::filterC_guided(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const uint32_t* guide, const int plane, const int y0, const int y1) noexcept
+{
+    int src_stride[15]{};
+    const size_t stride{ dst->GetPitch(plane) / sizeof(T) };
+    const size_t width{ dst->GetRowSize(plane) / sizeof(T) };
+    const T* srcp[15]{};
+    for (int i{ 0 }; i < _diameter; ++i)
+    {
+        src_stride[i] = src[i]->GetPitch(plane) / sizeof(T);
+        srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane)) + y0 * src_stride[i];
+    }
+
+    T* __restrict dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) + y0 * stride };
+    guide += y0 * guide_stride(width);
+
+    const float* const weightSaved{ _weight[plane >> 1].data() };
+
+    for (int y{ y0 }; y < y1; ++y)
+    {
+        for (size_t x{ 0 }; x < width; ++x)
+        {
+            const float c{ static_cast<float>(srcp[_maxr][x]) };
+            const uint32_t accepted{ guide[x] };
+            float weights{ _cw };
+            float sum{ c * _cw };
+
+            for (int i{ 0 }; i < _diameter; ++i)
+            {
+                if (!(accepted & (1 << i)))
+                    continue;
+
+                const float weight{ weightSaved[useDiff ? static_cast<int>(accepted >> 16) + 256 * (std::abs(i - _maxr) - 1) : i] };
+                weights += weight;
+                sum += srcp[i][x] * weight;
+            }
+
+            if constexpr (std::is_integral_v<T>)
+            {
+                if constexpr (fp)
+                    dstp[x] = static_cast<T>(c * (1.f - weights) + sum + 0.5f);
+                else
+                    dstp[x] = static_cast<T>(sum / weights + 0.5f);
+            }
+            else
+            {
+                if constexpr (fp)
+                    dstp[x] = c * (1.f - weights) + sum;
+                else
+                    dstp[x] = sum / weights;
+            }
+        }
+
+        for (int i{ 0 }; i < _diameter; ++i)
+            srcp[i] += src_stride[i];
+
+        dstp += stride;
+        guide += guide_stride(width);
     }
 }
 
 template<bool pfclip, bool fp>
 template<typename T>
-void TTempSmooth<pfclip, fp>::filter_mode2_C(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane)
+void TTempSmooth<pfclip, fp>::filter_mode2_C(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win)
 {
     int src_stride[(MAX_TEMP_RAD * 2 + 1)]{};
     int pf_stride[(MAX_TEMP_RAD * 2 + 1)]{};
@@ -289,7 +633,12 @@ void TTempSmooth<pfclip, fp>::filter_mode2_C(PVideoFrame src[(MAX_TEMP_RAD * 2 +
     iMEL_mem_hits = 0;
 #endif
 
-#pragma omp parallel for num_threads(_threads)
+    const bool touch{ !_iir_touched[l] && thUPD > 0 };
+    _iir_touched[l] = true;
+
+    const thread_budget budget(_threads);
+
+#pragma omp parallel for num_threads(budget.threads())
     for (int y = 0; y < height; ++y)
     {
         // local threads ptrs
@@ -307,6 +656,12 @@ void TTempSmooth<pfclip, fp>::filter_mode2_C(PVideoFrame src[(MAX_TEMP_RAD * 2 +
         pMem = g_pMem + y * width;
         pMemSum = g_pMemSum + y * width;
 
+        if (touch)
+        {
+            std::fill_n(pMem, width, 0);
+            std::fill_n(pMemSum, width, std::numeric_limits<working_t>::max());
+        }
+
         for (int x{ 0 }; x < width; ++x)
         {
 
@@ -314,11 +669,13 @@ void TTempSmooth<pfclip, fp>::filter_mode2_C(PVideoFrame src[(MAX_TEMP_RAD * 2 +
             working_t wt_sum_minrow = MaxSumDM;
             int i_idx_minrow = 0;
 
-            for (int dmt_row = 0; dmt_row < (_maxr * 2 + 1); dmt_row++)
+            for (int wr = 0; wr < win.num; wr++)
             {
+                const int dmt_row = win.slot[wr];
                 working_t wt_sum_row = 0;
-                for (int dmt_col = 0; dmt_col < (_maxr * 2 + 1); dmt_col++)
+                for (int wc = 0; wc < win.num; wc++)
                 {
+                    const int dmt_col = win.slot[wc];
                     if (dmt_row == dmt_col)
                     { // block with itself => DM=0
                         continue;
@@ -346,7 +703,8 @@ void TTempSmooth<pfclip, fp>::filter_mode2_C(PVideoFrame src[(MAX_TEMP_RAD * 2 +
                         col_data_ptr = (T*)&srcp[dmt_col][x];
                     }
 
-                    wt_sum_row += (sizeof(T) <= 2) ? INTABS(*row_data_ptr - *col_data_ptr) : std::abs(*row_data_ptr - *col_data_ptr);
+                    // win.mult[wc]: copies of a clamped edge frame
+                    wt_sum_row += win.mult[wc] * ((sizeof(T) <= 2) ? INTABS(*row_data_ptr - *col_data_ptr) : std::abs(*row_data_ptr - *col_data_ptr));
                 }
 
                 if (wt_sum_row < wt_sum_minrow)
@@ -418,25 +776,116 @@ void TTempSmooth<pfclip, fp>::filter_mode2_C(PVideoFrame src[(MAX_TEMP_RAD * 2 +
 
 
 
-template <typename pixel_t>
-AVS_FORCEINLINE static float get_sad_c(const pixel_t* c_plane, const pixel_t* t_plane, size_t height, size_t width, size_t c_pitch, size_t t_pitch) noexcept
+template <bool pfclip, bool fp>
+template <typename T>
+void TTempSmooth<pfclip, fp>::filter_recursive_C(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane)
 {
-    float accum{ 0.0f };
+    const size_t stride{ dst->GetPitch(plane) / sizeof(T) };
+    const size_t width{ dst->GetRowSize(plane) / sizeof(T) };
+    const int height{ dst->GetHeight(plane) };
+    const int l{ plane >> 1 };
+    size_t src_stride[3];
+    size_t pf_stride[3];
+    const T* g_srcp[3];
+    const T* g_pfp[3];
+
+    for (int i{ 0 }; i < 3; ++i)
+    {
+        src_stride[i] = src[i]->GetPitch(plane) / sizeof(T);
+        pf_stride[i] = pf[i]->GetPitch(plane) / sizeof(T);
+        g_srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane));
+        g_pfp[i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(plane));
+    }
+
+    T* g_dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) };
+
+    const float thresh{ (std::is_same_v<T, float>) ? _threshF[l] : static_cast<float>(_thresh[l] << _shift) };
+    // difference to the index of the 8-bit weight table
+    const float scale{ (std::is_same_v<T, float>) ? 255.0f : 1.0f / (1 << _shift) };
+    const float* weight{ _weight[l].data() };
+    // the history is dropped after a scene change or a request out of order
+    const bool reset{ fromFrame >= 1 };
+    const bool next{ toFrame > 2 };
+
+    // rows of the weighted sum, the sum of weights and (pfclip) the weighted sum of pfclip
+    float* g_state{ reinterpret_cast<float*>(pIIRMem[l].data()) };
+    constexpr int fields{ (pfclip) ? 3 : 2 };
+    const size_t state_width{ recursive_stride(width) };
+
+    const thread_budget budget(_threads);
 
-    for (size_t y{ 0 }; y < height; ++y)
+#pragma omp parallel for num_threads(budget.threads())
+    for (int y = 0; y < height; ++y)
     {
+        const T* prevp{ g_pfp[0] + y * pf_stride[0] };
+        const T* srcp{ g_srcp[1] + y * src_stride[1] };
+        const T* pfp{ g_pfp[1] + y * pf_stride[1] };
+        const T* nextp{ g_srcp[2] + y * src_stride[2] };
+        const T* next_pfp{ g_pfp[2] + y * pf_stride[2] };
+        T* __restrict dstp{ g_dstp + y * stride };
+        float* acc{ g_state + y * state_width * fields };
+        float* wsum{ acc + state_width };
+        float* acc_pf{ (pfclip) ? wsum + state_width : acc };
+
         for (size_t x{ 0 }; x < width; ++x)
-            accum += std::abs(t_plane[x] - c_plane[x]);
+        {
+            const float c{ static_cast<float>(srcp[x]) };
+            const float c_pf{ static_cast<float>(pfp[x]) };
+            float k{ 0.0f };
 
-        c_plane += c_pitch;
-        t_plane += t_pitch;
-    }
+            // the previous frame and the average of the history must both pass the motion test
+            if (!reset)
+            {
+                const float diff_prev{ std::abs(c_pf - prevp[x]) };
+                const float diff{ std::abs(c_pf - acc_pf[x] / wsum[x]) };
+
+                if (diff_prev < thresh && diff < thresh)
+                    k = _decay * weight[std::min(static_cast<int>(diff * scale), 255)];
+            }
+
+            if (k > 0.0f)
+            {
+                if constexpr (pfclip)
+                    acc_pf[x] = c_pf + k * acc_pf[x];
+
+                acc[x] = c + k * acc[x];
+                wsum[x] = 1.0f + k * wsum[x];
+            }
+            else
+            {
+                if constexpr (pfclip)
+                    acc_pf[x] = c_pf;
+
+                acc[x] = c;
+                wsum[x] = 1.0f;
+            }
+
+            float sum{ acc[x] };
+            float weights{ wsum[x] };
 
-    return accum;
+            // the next frame is weighted like the previous one but not kept
+            if (next)
+            {
+                const float diff{ std::abs(next_pfp[x] - c_pf) };
+
+                if (diff < thresh)
+                {
+                    const float w{ _decay * weight[std::min(static_cast<int>(diff * scale), 255)] };
+                    sum += w * nextp[x];
+                    weights += w;
+                }
+            }
+
+            if constexpr (std::is_same_v<T, float>)
+                dstp[x] = sum / weights;
+            else
+                dstp[x] = static_cast<T>(sum / weights + 0.5f);
+        }
+    }
 }
 
 template <typename T>
-static float ComparePlane(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept
+static float ComparePlane(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept
 {
     const size_t pitch{ src->GetPitch(PLANAR_Y) / sizeof(T) };
     const size_t pitch2{ src1->GetPitch(PLANAR_Y) / sizeof(T) };
@@ -445,66 +894,534 @@ static float ComparePlane(PVideoFrame& src, PVideoFrame& src1, const int bits_pe
     const T* srcp{ reinterpret_cast<const T*>(src->GetReadPtr(PLANAR_Y)) };
     const T* srcp2{ reinterpret_cast<const T*>(src1->GetReadPtr(PLANAR_Y)) };
 
-    const float sad{ get_sad_c<T>(srcp, srcp2, height, width, pitch, pitch2) };
+    const double norm{ ((std::is_integral_v<T>) ? static_cast<double>((1 << bits_per_pixel) - 1) : 1.0) * height * width };
+    const double sad_limit{ limit * norm };
+    std::conditional_t<std::is_integral_v<T>, uint64_t, float> sad{ 0 };
 
-    float f{ sad / (height * width) };
+    for (int y{ 0 }; y < height && sad <= sad_limit; ++y)
+    {
+        for (size_t x{ 0 }; x < width; ++x)
+            sad += std::abs(srcp2[x] - srcp[x]);
 
-    if constexpr (std::is_integral_v<T>)
-        f /= ((1 << bits_per_pixel) - 1);
+        srcp += pitch;
+        srcp2 += pitch2;
+    }
 
-    return f;
+    return static_cast<float>(sad / norm);
 }
 
-template <bool pfclip, bool fp>
-TTempSmooth<pfclip, fp>::TTempSmooth(PClip _child, int maxr, int ythresh, int uthresh, int vthresh, int ymdiff, int umdiff, int vmdiff, int strength, float scthresh, int y, int u, int v, PClip pfclip_, int opt, int pmode, int ythupd, int uthupd, int vthupd, int ypnew, int upnew, int vpnew, int threads, IScriptEnvironment* env)
-    : GenericVideoFilter(_child), _maxr(maxr), _scthresh(scthresh), _diameter(maxr * 2 + 1), _thresh{ ythresh, uthresh, vthresh }, _mdiff{ ymdiff, umdiff, vmdiff }, _shift(vi.BitsPerComponent() - 8), _threshF{ 0.0f, 0.0f, 0.0f },
-    _cw(0.0f), _pfclip(pfclip_), _opt(opt), _pmode(pmode), _thUPD{ ythupd, uthupd, vthupd }, _pnew{ ypnew, upnew, vpnew }, _threads{ threads }
+// sums of the step x step blocks of the luma plane; a partial last block row/column is left out
+template <typename T>
+static void ThumbnailPlane(PVideoFrame& src, const int step, std::vector<float>& thumb)
 {
-    has_at_least_v8 = env->FunctionExists("propShow");
+    const size_t pitch{ src->GetPitch(PLANAR_Y) / sizeof(T) };
+    const int width{ src->GetRowSize(PLANAR_Y) / static_cast<int>(sizeof(T)) / step };
+    const int height{ src->GetHeight(PLANAR_Y) / step };
+    const T* srcp{ reinterpret_cast<const T*>(src->GetReadPtr(PLANAR_Y)) };
 
-    if (vi.IsRGB() || !vi.IsPlanar())
-        env->ThrowError("vsTTempSmooth: clip must be Y/YUV(A) 8..32-bit planar format.");
-    if (_maxr < 1 || _maxr > MAX_TEMP_RAD)
-        env->ThrowError("vsTTempSmooth: maxr must be between 1..%d.", MAX_TEMP_RAD);
-    if (ythresh < 1 || ythresh > 256)
-        env->ThrowError("vsTTempSmooth: ythresh must be between 1..256.");
-    if (uthresh < 1 || uthresh > 256)
-        env->ThrowError("vsTTempSmooth: uthresh must be between 1..256.");
-    if (vthresh < 1 || vthresh > 256)
-        env->ThrowError("vsTTempSmooth: vthresh must be between 1..256.");
-    if (ymdiff < 0 || ymdiff > 255)
-        env->ThrowError("vsTTempSmooth: ymdiff must be between 0..255.");
-    if (umdiff < 0 || umdiff > 255)
-        env->ThrowError("vsTTempSmooth: umdiff must be between 0..255.");
-    if (vmdiff < 0 || vmdiff > 255)
-        env->ThrowError("vsTTempSmooth: vmdiff must be between 0..255.");
-    if (strength < 1 || strength > 8)
-        env->ThrowError("vsTTempSmooth: strength must be between 1..8.");
-    if (_scthresh < 0.f || _scthresh > 100.f)
-        env->ThrowError("vsTTempSmooth: scthresh must be between 0.0..100.0.");
-    if (_opt < -1 || _opt > 3)
-        env->ThrowError("vsTTempSmooth: opt must be between -1..3.");
-    if (_pmode < 0 || _pmode > 1)
-        env->ThrowError("vsTTempSmooth: pmode must be either 0 or 1.");
-    if (ythupd < 0)
-        env->ThrowError("vsTTempSmooth: ythupd must be greater than 0.");
-    if (uthupd < 0)
-        env->ThrowError("vsTTempSmooth: uthupd must be greater than 0.");
-    if (vthupd < 0)
-        env->ThrowError("vsTTempSmooth: vthupd must be greater than 0.");
-    if (ypnew < 0)
+    thumb.assign(static_cast<size_t>(width) * height, 0.0f);
+
+    for (int y{ 0 }; y < height * step; ++y)
+    {
+        float* thumbp{ thumb.data() + static_cast<size_t>(y / step) * width };
+
+        for (int x{ 0 }; x < width; ++x)
+        {
+            float sum{ 0.0f };
+
+            for (int i{ 0 }; i < step; ++i)
+                sum += srcp[x * step + i];
+
+            thumbp[x] += sum;
+        }
+
+        srcp += pitch;
+    }
+}
+
+// FNV-1a of 16 evenly spaced rows of the luma plane, continuing from hash
+static uint64_t HashPlane(const PVideoFrame& src, uint64_t hash) noexcept
+{
+    const int row_size{ src->GetRowSize(PLANAR_Y) };
+    const int height{ src->GetHeight(PLANAR_Y) };
+    const uint8_t* srcp{ src->GetReadPtr(PLANAR_Y) };
+
+    for (int i{ 0 }; i < std::min(height, 16); ++i)
+    {
+        const uint8_t* row{ srcp + static_cast<size_t>(src->GetPitch(PLANAR_Y)) * (static_cast<int64_t>(height - 1) * i / 15) };
+
+        for (int x{ 0 }; x < row_size; ++x)
+            hash = (hash ^ row[x]) * 0x100000001b3;
+    }
+
+    return hash;
+}
+
+// rounds a 10..16-bit plane to 8 bits
+static void CompactPlane(const PVideoFrame& src, const PVideoFrame& dst, const int plane, const int shift) noexcept
+{
+    const size_t src_pitch{ src->GetPitch(plane) / sizeof(uint16_t) };
+    const size_t dst_pitch{ static_cast<size_t>(dst->GetPitch(plane)) };
+    const size_t width{ static_cast<size_t>(dst->GetRowSize(plane)) };
+    const int height{ dst->GetHeight(plane) };
+    const uint16_t* srcp{ reinterpret_cast<const uint16_t*>(src->GetReadPtr(plane)) };
+    uint8_t* __restrict dstp{ dst->GetWritePtr(plane) };
+    const int round{ 1 << (shift - 1) };
+
+    for (int y{ 0 }; y < height; ++y)
+    {
+        for (size_t x{ 0 }; x < width; ++x)
+            dstp[x] = static_cast<uint8_t>(std::min((srcp[x] + round) >> shift, 255));
+
+        srcp += src_pitch;
+        dstp += dst_pitch;
+    }
+}
+
+// output plane of the compact window at full precision; samples equal to the 8-bit center are taken from the full-precision center
+static void ExpandPlane(const PVideoFrame& dst8, const PVideoFrame& center8, const PVideoFrame& center, const PVideoFrame& dst, const int plane, const int shift, const int threads) noexcept
+{
+    const size_t dst8_pitch{ static_cast<size_t>(dst8->GetPitch(plane)) };
+    const size_t center8_pitch{ static_cast<size_t>(center8->GetPitch(plane)) };
+    const size_t center_pitch{ center->GetPitch(plane) / sizeof(uint16_t) };
+    const size_t dst_pitch{ dst->GetPitch(plane) / sizeof(uint16_t) };
+    const size_t width{ static_cast<size_t>(dst8->GetRowSize(plane)) };
+    const int height{ dst8->GetHeight(plane) };
+    const uint8_t* g_dst8p{ dst8->GetReadPtr(plane) };
+    const uint8_t* g_center8p{ center8->GetReadPtr(plane) };
+    const uint16_t* g_centerp{ reinterpret_cast<const uint16_t*>(center->GetReadPtr(plane)) };
+    uint16_t* g_dstp{ reinterpret_cast<uint16_t*>(dst->GetWritePtr(plane)) };
+    const thread_budget budget(threads);
+
+#pragma omp parallel for num_threads(budget.threads())
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* dst8p{ g_dst8p + y * dst8_pitch };
+        const uint8_t* center8p{ g_center8p + y * center8_pitch };
+        const uint16_t* centerp{ g_centerp + y * center_pitch };
+        uint16_t* __restrict dstp{ g_dstp + y * dst_pitch };
+
+        for (size_t x{ 0 }; x < width; ++x)
+            dstp[x] = (dst8p[x] == center8p[x]) ? centerp[x] : static_cast<uint16_t>(dst8p[x] << shift);
+    }
+}
+
+// noisy gradient for the tuning runs; frames of other seeds differ by a few steps so some samples pass the motion test and some fail
+template <typename T>
+static void SyntheticPlane(const PVideoFrame& dst, const int plane, const int seed, const int shift) noexcept
+{
+    const size_t pitch{ dst->GetPitch(plane) / sizeof(T) };
+    const int width{ dst->GetRowSize(plane) / static_cast<int>(sizeof(T)) };
+    const int height{ dst->GetHeight(plane) };
+    T* dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) };
+    uint32_t state{ 0x9E3779B9u * (seed + 1) };
+
+    for (int y{ 0 }; y < height; ++y)
+    {
+        for (int x{ 0 }; x < width; ++x)
+        {
+            state = state * 1664525u + 1013904223u;
+            const int v{ ((x + y) & 127) + 64 + static_cast<int>(state >> 29) };
+
+            if constexpr (std::is_same_v<T, float>)
+                dstp[x] = v / 255.0f;
+            else
+                dstp[x] = static_cast<T>(v << shift);
+        }
+
+        dstp += pitch;
+    }
+}
+
+int processor_count() noexcept
+{
+    int count{ std::max(static_cast<int>(std::thread::hardware_concurrency()), 1) };
+
+#ifdef _WIN32
+    DWORD_PTR process_mask, system_mask;
+
+    // the mask covers the processor group of the process only
+    if (count <= 64 && GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) && process_mask)
+    {
+        int bits{ 0 };
+
+        for (; process_mask; process_mask &= process_mask - 1)
+            ++bits;
+
+        count = std::min(count, bits);
+    }
+#else
+    cpu_set_t set;
+
+    if (!sched_getaffinity(0, sizeof(set), &set))
+        count = std::max(CPU_COUNT(&set), 1);
+
+    // CPUs of the quota: cpu.max of every level of the cgroup v2 hierarchy, cpu.cfs_quota_us of cgroup v1; "max" and -1 mean no limit
+    double limit{ 0.0 };
+    const auto quota = [&](const double q, const double period)
+    {
+        if (q > 0.0 && period > 0.0)
+            limit = (limit > 0.0) ? std::min(limit, q / period) : q / period;
+    };
+
+    std::string path;
+
+    if (FILE* f{ fopen("/proc/self/cgroup", "r") })
+    {
+        char line[4096];
+
+        while (fgets(line, sizeof(line), f))
+        {
+            if (!strncmp(line, "0::", 3))
+            {
+                path = line + 3;
+                path.erase(path.find_last_not_of('\n') + 1);
+            }
+        }
+
+        fclose(f);
+    }
+
+    for (;;)
+    {
+        if (FILE* f{ fopen(("/sys/fs/cgroup" + path + "/cpu.max").c_str(), "r") })
+        {
+            double q, period;
+
+            if (fscanf(f, "%lf %lf", &q, &period) == 2)
+                quota(q, period);
+
+            fclose(f);
+        }
+
+        if (path.empty() || path == "/")
+            break;
+
+        path.erase(path.rfind('/'));
+    }
+
+    if (FILE* f{ fopen("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", "r") })
+    {
+        double q;
+
+        if (fscanf(f, "%lf", &q) == 1)
+        {
+            if (FILE* f1{ fopen("/sys/fs/cgroup/cpu/cpu.cfs_period_us", "r") })
+            {
+                double period;
+
+                if (fscanf(f1, "%lf", &period) == 1)
+                    quota(q, period);
+
+                fclose(f1);
+            }
+        }
+
+        fclose(f);
+    }
+
+    if (limit > 0.0)
+        count = std::min(count, std::max(static_cast<int>(std::ceil(limit)), 1));
+#endif
+
+    return count;
+}
+
+// buffers of 2 MB and more on huge pages: large pages need the "Lock pages in memory" privilege on Windows,
+// transparent huge pages are requested on Linux; normal pages otherwise
+void* huge_page_alloc(const size_t size)
+{
+    void* p{ nullptr };
+
+#ifdef _WIN32
+    const size_t large{ GetLargePageMinimum() };
+
+    if (large && size >= large)
+        p = VirtualAlloc(nullptr, (size + large - 1) & ~(large - 1), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (!p)
+        p = VirtualAlloc(nullptr, std::max<size_t>(size, 1), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    constexpr size_t huge_page{ 2 << 20 };
+
+    if (size >= huge_page)
+    {
+        const size_t rounded{ (size + huge_page - 1) & ~(huge_page - 1) };
+
+        if (!posix_memalign(&p, huge_page, rounded))
+        {
+#ifdef MADV_HUGEPAGE
+            madvise(p, rounded, MADV_HUGEPAGE);
+#endif
+        }
+        else
+            p = nullptr;
+    }
+    else
+        p = std::malloc(std::max<size_t>(size, 1));
+#endif
+
+    if (!p)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+// 1 if a buffer of huge_page_alloc got huge pages, 0 if it didn't, -1 if it's too small to ask for them
+static int huge_page_status(const void* p, const size_t size)
+{
+#ifdef _WIN32
+    const size_t large{ GetLargePageMinimum() };
+
+    if (size < ((large) ? large : (2 << 20)))
+        return -1;
+
+    PSAPI_WORKING_SET_EX_INFORMATION info{};
+    info.VirtualAddress = const_cast<void*>(p);
+
+    if (!large || !QueryWorkingSetEx(GetCurrentProcess(), &info, sizeof(info)))
+        return 0;
+
+    return info.VirtualAttributes.Valid && info.VirtualAttributes.LargePage;
+#else
+    if (size < (2 << 20))
+        return -1;
+
+    // the pages aren't touched yet: the kernel tells whether the mapping is eligible for transparent huge pages
+    FILE* f{ std::fopen("/proc/self/smaps", "r") };
+    if (!f)
+        return 0;
+
+    const unsigned long long address{ reinterpret_cast<uintptr_t>(p) };
+    char line[512];
+    bool mapping{ false };
+    int eligible{ 0 };
+
+    while (std::fgets(line, sizeof(line), f))
+    {
+        unsigned long long start;
+        unsigned long long end;
+
+        if (std::sscanf(line, "%llx-%llx ", &start, &end) == 2)
+        {
+            if (mapping)
+                break;
+
+            mapping = address >= start && address < end;
+        }
+        else if (mapping && std::sscanf(line, "THPeligible: %d", &eligible) == 1)
+            break;
+    }
+
+    std::fclose(f);
+
+    return eligible == 1;
+#endif
+}
+
+void huge_page_free(void* p) noexcept
+{
+#ifdef _WIN32
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    std::free(p);
+#endif
+}
+
+// size in bytes of the data/unified cache of the given level, 0 if cpuid doesn't report it
+static int cache_size(const int level) noexcept
+{
+    int abcd[4]{};
+    cpuid(abcd, 0);
+    const int max_leaf{ abcd[0] };
+    cpuid(abcd, 0x80000000);
+    const unsigned max_ext_leaf{ static_cast<unsigned>(abcd[0]) };
+
+    // leaf 4 on Intel, 0x8000001D on AMD; both use the same layout
+    for (const unsigned leaf : { 4u, 0x8000001Du })
+    {
+        if ((leaf == 4) ? (max_leaf < 4) : (max_ext_leaf < leaf))
+            continue;
+
+        for (int i{ 0 }; i < 16; ++i)
+        {
+            cpuid(abcd, leaf, i);
+            const int type{ abcd[0] & 0x1F };
+
+            if (type == 0)
+                break;
+            if (type != 2 && ((abcd[0] >> 5) & 0x7) == level)
+                return (((abcd[1] >> 22) & 0x3FF) + 1) * (((abcd[1] >> 12) & 0x3FF) + 1) * ((abcd[1] & 0xFFF) + 1) * (abcd[2] + 1);
+        }
+    }
+
+    return 0;
+}
+
+struct ScFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    int32_t num_frames;
+    int32_t width;
+    int32_t height;
+    int32_t bits;
+    int32_t scstep;
+    // hash of the compared frames 0, num_frames / 2 and num_frames - 1, 0 until the first request
+    uint64_t fingerprint;
+};
+
+static constexpr char scfile_magic[8]{ 'v', 's', 'T', 'T', 'S', 'S', 'C', '\0' };
+static constexpr uint32_t scfile_version{ 2 };
+
+// maps size bytes of path; for writing the file is created or resized to size if needed (resized is set then)
+static void* map_scfile(const char* path, const size_t size, const bool write, bool& resized)
+{
+    void* view{ nullptr };
+    resized = false;
+
+#ifdef _WIN32
+    HANDLE file{ CreateFileA(path, (write) ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, (write) ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER file_size;
+
+    if (GetFileSizeEx(file, &file_size))
+    {
+        LARGE_INTEGER new_size;
+        new_size.QuadPart = size;
+        resized = static_cast<size_t>(file_size.QuadPart) != size;
+
+        if (!resized || (write && SetFilePointerEx(file, new_size, nullptr, FILE_BEGIN) && SetEndOfFile(file)))
+        {
+            HANDLE mapping{ CreateFileMappingA(file, nullptr, (write) ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr) };
+
+            if (mapping)
+            {
+                view = MapViewOfFile(mapping, (write) ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+                CloseHandle(mapping);
+            }
+        }
+    }
+
+    CloseHandle(file);
+#else
+    const int fd{ open(path, (write) ? O_RDWR | O_CREAT : O_RDONLY, 0644) };
+
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+
+    if (!fstat(fd, &st))
+    {
+        resized = static_cast<size_t>(st.st_size) != size;
+
+        if (!resized || (write && !ftruncate(fd, size)))
+        {
+            view = mmap(nullptr, size, (write) ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+
+            if (view == MAP_FAILED)
+                view = nullptr;
+        }
+    }
+
+    close(fd);
+#endif
+
+    return view;
+}
+
+static void unmap_scfile(void* view, const size_t size)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+#else
+    munmap(view, size);
+#endif
+}
+
+template <bool pfclip, bool fp>
+TTempSmooth<pfclip, fp>::TTempSmooth(PClip _child, int maxr, int ythresh, int uthresh, int vthresh, int ymdiff, int umdiff, int vmdiff, int strength, float scthresh, int y, int u, int v, PClip pfclip_, int opt, int pmode, int ythupd, int uthupd, int vthupd, int ypnew, int upnew, int vpnew, int threads, int tile, int batch, int scstep, int scprops, const char* scfile, int scfilemode, bool compact, bool chromaguide, bool lookahead, bool recursive, int fmaxr, IScriptEnvironment* env)
+    : GenericVideoFilter(_child), _maxr(std::max(maxr, fmaxr)), _bmaxr{ maxr }, _fmaxr{ fmaxr }, _scthresh(scthresh), _diameter(std::max(maxr, fmaxr) * 2 + 1), _thresh{ ythresh, uthresh, vthresh }, _mdiff{ ymdiff, umdiff, vmdiff }, _shift(vi.BitsPerComponent() - 8), _threshF{ 0.0f, 0.0f, 0.0f },
+    _cw(0.0f), _pfclip(pfclip_), _opt(opt), _pmode(pmode), _thUPD{ ythupd, uthupd, vthupd }, _iir_touched{ false, false, false }, _recursive{ recursive }, _decay{ 0.0f }, _recursive_n{ -1 }, _pnew{ ypnew, upnew, vpnew }, _threads{ threads }, _tile{ tile }, _batch{ batch }, _scstep{ scstep }, _scprops{ scprops }, _chromaguide{ chromaguide }, _huge_pages{ -1 },
+    _ahead_first{ 0 }, _last_n{ -1 }, _requests{ 0 }, _window_bypass{ false }, _scfile{ nullptr }, _scfile_view{ nullptr }, _scfile_size{ 0 }, _scfilemode{ scfilemode },
+    _compact{ compact }, _compact_shift{ 0 }, _sc_bits{ vi.BitsPerComponent() }, _lookahead{ lookahead }, _lookahead_first{ 0 }
+{
+    has_at_least_v8 = env->FunctionExists("propShow");
+
+    if (vi.IsRGB() || !vi.IsPlanar())
+        env->ThrowError("vsTTempSmooth: clip must be Y/YUV(A) 8..32-bit planar format.");
+    if (maxr < 1 || maxr > MAX_TEMP_RAD)
+        env->ThrowError("vsTTempSmooth: maxr must be between 1..%d.", MAX_TEMP_RAD);
+    if (fmaxr < 0 || fmaxr > MAX_TEMP_RAD)
+        env->ThrowError("vsTTempSmooth: fmaxr must be between 0..%d.", MAX_TEMP_RAD);
+    if (ythresh < 1 || ythresh > 256)
+        env->ThrowError("vsTTempSmooth: ythresh must be between 1..256.");
+    if (uthresh < 1 || uthresh > 256)
+        env->ThrowError("vsTTempSmooth: uthresh must be between 1..256.");
+    if (vthresh < 1 || vthresh > 256)
+        env->ThrowError("vsTTempSmooth: vthresh must be between 1..256.");
+    if (ymdiff < 0 || ymdiff > 255)
+        env->ThrowError("vsTTempSmooth: ymdiff must be between 0..255.");
+    if (umdiff < 0 || umdiff > 255)
+        env->ThrowError("vsTTempSmooth: umdiff must be between 0..255.");
+    if (vmdiff < 0 || vmdiff > 255)
+        env->ThrowError("vsTTempSmooth: vmdiff must be between 0..255.");
+    if (strength < 1 || strength > 8)
+        env->ThrowError("vsTTempSmooth: strength must be between 1..8.");
+    if (_scthresh < 0.f || _scthresh > 100.f)
+        env->ThrowError("vsTTempSmooth: scthresh must be between 0.0..100.0.");
+    if (_opt < -2 || _opt > 3)
+        env->ThrowError("vsTTempSmooth: opt must be between -2..3.");
+    if (_pmode < 0 || _pmode > 1)
+        env->ThrowError("vsTTempSmooth: pmode must be either 0 or 1.");
+    if (_pmode == 0 && maxr > 7 && !_recursive)
+        env->ThrowError("vsTTempSmooth: pmode=0 maxr must be between 1..7.");
+    if (_pmode == 0 && fmaxr > 7 && !_recursive)
+        env->ThrowError("vsTTempSmooth: pmode=0 fmaxr must be between 0..7.");
+    if (ythupd < 0)
+        env->ThrowError("vsTTempSmooth: ythupd must be greater than 0.");
+    if (uthupd < 0)
+        env->ThrowError("vsTTempSmooth: uthupd must be greater than 0.");
+    if (vthupd < 0)
+        env->ThrowError("vsTTempSmooth: vthupd must be greater than 0.");
+    if (ypnew < 0)
         env->ThrowError("vsTTempSmooth: ypnew must be greater than 0.");
     if (upnew < 0)
         env->ThrowError("vsTTempSmooth: upnew must be greater than 0.");
     if (vpnew < 0)
         env->ThrowError("vsTTempSmooth: vpnew must be greater than 0.");
-
-    const uint32_t thr{ std::thread::hardware_concurrency() };
-
-    if (_threads == 0)
-        _threads = thr;
-    else if (_threads < 0 || _threads > thr)
-        env->ThrowError("vsTTempSmooth: threads must be between 0..%s.", std::to_string(thr).c_str());
+    if (_tile < -1)
+        env->ThrowError("vsTTempSmooth: tile must be greater than or equal to -1.");
+    if (_batch < 1 || _batch > MAX_BATCH)
+        env->ThrowError("vsTTempSmooth: batch must be between 1..%d.", MAX_BATCH);
+    if (_scstep < 1 || _scstep > std::min(vi.width, vi.height))
+        env->ThrowError("vsTTempSmooth: scstep must be between 1..%d.", std::min(vi.width, vi.height));
+    if (_scprops < 0 || _scprops > 3)
+        env->ThrowError("vsTTempSmooth: scprops must be between 0..3.");
+    if (_scprops && !has_at_least_v8)
+        env->ThrowError("vsTTempSmooth: scprops requires frame properties support (AviSynth+ 3.6+).");
+    if (_scfilemode < 0 || _scfilemode > 1)
+        env->ThrowError("vsTTempSmooth: scfilemode must be either 0 or 1.");
+    if (_compact && (_pmode != 1 || vi.ComponentSize() != 2))
+        env->ThrowError("vsTTempSmooth: compact requires pmode=1 and 10..16-bit clip.");
+    if (_chromaguide && (_pmode != 0 || vi.NumComponents() < 3 || y != 3))
+        env->ThrowError("vsTTempSmooth: chromaguide requires pmode=0, YUV clip and y=3.");
+    if (_recursive && (_pmode != 0 || _chromaguide))
+        env->ThrowError("vsTTempSmooth: recursive requires pmode=0 and chromaguide=false.");
+
+    // threads=0 uses the processors the process may run on, the limit is all logical processors of the machine
+    const int thr{ static_cast<int>(std::thread::hardware_concurrency()) };
+    const int cpus{ processor_count() };
+    // threads=-1 starts from all processors and is tuned once the kernels can run
+    const bool tune_threads{ _threads == -1 };
+
+    if (_threads == 0 || tune_threads)
+        _threads = cpus;
+    else if (_threads < -1 || _threads > thr)
+        env->ThrowError("vsTTempSmooth: threads must be between -1..%s (logical processors).", std::to_string(thr).c_str());
 
     const int iset{ instrset_detect() };
 
@@ -514,6 +1431,9 @@ TTempSmooth<pfclip, fp>::TTempSmooth(PClip _child, int maxr, int ythresh, int ut
         env->ThrowError("vsTTempSmooth: opt=2 requires AVX2.");
     if (_opt == 3 && iset < 10)
         env->ThrowError("vsTTempSmooth: opt=3 requires AVX512F.");
+    // the only choice of code with the same output is AVX2 or AVX-512
+    if (_opt == -2 && iset < 10)
+        env->ThrowError("vsTTempSmooth: opt=-2 requires AVX512F.");
 
     if constexpr (pfclip)
     {
@@ -525,8 +1445,6 @@ TTempSmooth<pfclip, fp>::TTempSmooth(PClip _child, int maxr, int ythresh, int ut
     }
 
     const int planes[3] = { y, u, v };
-    static constexpr int iMaxSum = std::numeric_limits<int>::max();
-    static constexpr float fMaxSum = std::numeric_limits<float>::max();
 
     for (int i{ 0 }; i < std::min(vi.NumComponents(), 3); ++i)
     {
@@ -542,7 +1460,30 @@ TTempSmooth<pfclip, fp>::TTempSmooth(PClip _child, int maxr, int ythresh, int ut
         {
             if (_pmode == 0)
             {
-                if (_thresh[i] > _mdiff[i] + 1)
+                if (_recursive)
+                {
+                    // inverse difference weight of the history relative to the current sample
+                    _weight[i].assign(256, 0.0f);
+                    const float step{ 1.f / (_thresh[i] - std::min(_mdiff[i], _thresh[i] - 1)) };
+                    float base{ 1.f };
+
+                    for (int j{ 0 }; j < _thresh[i] && j < 256; ++j)
+                    {
+                        if (_mdiff[i] > j)
+                            _weight[i][j] = 1.f;
+                        else
+                        {
+                            if (base <= 0.f)
+                                break;
+
+                            _weight[i][j] = base;
+                            base -= step;
+                        }
+                    }
+
+                    pIIRMem[i].resize(recursive_stride(vi.width) * vi.height * sizeof(float) * ((pfclip) ? 3 : 2));
+                }
+                else if (_thresh[i] > _mdiff[i] + 1)
                 {
                     _weight[i].resize(256 * _maxr);
                     float dt[15] = {}, rt[256] = {}, sum = 0.f;
@@ -573,7 +1514,8 @@ TTempSmooth<pfclip, fp>::TTempSmooth(PClip _child, int maxr, int ythresh, int ut
                     sum += dt[0];
                     for (int j{ 1 }; j <= _maxr; ++j)
                     {
-                        sum += dt[j] * 2.f;
+                        // the distance is on both sides of the current frame only within both radii
+                        sum += dt[j] * ((j <= _bmaxr) + (j <= _fmaxr));
                         for (int v{ 0 }; v < 256; ++v)
                             _weight[i][256 * (j - 1) + v] = dt[j] * rt[v] / 256.f;
                     }
@@ -593,6 +1535,10 @@ TTempSmooth<pfclip, fp>::TTempSmooth(PClip _child, int maxr, int ythresh, int ut
                     for (int i{ strength }; i <= _maxr; ++i)
                         dt[_maxr - i] = dt[_maxr + i] = 1.f / (i - strength + 2);
 
+                    // frames outside the radii are not in the window
+                    std::fill(dt, dt + _maxr - _bmaxr, 0.f);
+                    std::fill(dt + _maxr + _fmaxr + 1, dt + _diameter, 0.f);
+
                     for (int j{ 0 }; j < _diameter; ++j)
                     {
                         sum += dt[j];
@@ -610,53 +1556,242 @@ TTempSmooth<pfclip, fp>::TTempSmooth(PClip _child, int maxr, int ythresh, int ut
             }
             else if (_pmode == 1 && _thUPD[i] > 0)
             {
-                pIIRMem[i].resize(vi.width * vi.height * vi.ComponentSize(), 0);
+                pIIRMem[i].resize(vi.width * vi.height * vi.ComponentSize());
 
                 if (vi.ComponentSize() < 4)
-                    pMinSumMem[i].resize(vi.width * vi.height, iMaxSum);
+                    pMinSumMem[i].resize(vi.width * vi.height);
                 else
-                    pMinSumMemF[i].resize(vi.width * vi.height, fMaxSum);
+                    pMinSumMemF[i].resize(vi.width * vi.height);
             }
         }
     }
 
-    if ((_opt == -1 && iset >= 10) || _opt == 3)
+    // maxr sets the length of the history; the window is the previous, current and next frame
+    if (_recursive)
+    {
+        _decay = _bmaxr / (_bmaxr + 1.0f);
+        _maxr = 1;
+        _bmaxr = 1;
+        _fmaxr = std::min(_fmaxr, 1);
+        _diameter = 3;
+    }
+
+    // opt=-2 starts from the auto-detected code and is tuned once the kernels can run
+    bool tune_opt{ _opt == -2 };
+
+    if ((_opt < 0 && iset >= 10) || _opt == 3)
         _opt = 3;
-    else if ((_opt == -1 && iset >= 8) || _opt == 2)
+    else if ((_opt < 0 && iset >= 8) || _opt == 2)
         _opt = 2;
-    else if ((_opt == -1 && iset >= 2) || _opt == 1)
+    else if ((_opt < 0 && iset >= 2) || _opt == 1)
         _opt = 1;
     else
         _opt = 0;
 
     if (_pmode == 1)
     {
+        if (tune_opt && _opt == 3 && vi.ComponentSize() < 4 && !_compact)
+            _opt = 2;
+        else if (tune_opt && _opt == 1)
+            _opt = 0;
+
         if (!(_opt == 0 || _opt == 2 || _opt == 3))
             env->ThrowError("vsTTempSmooth: pmode=1 requires opt=0, opt=2 or opt=3.");
-        if (_opt == 3 && vi.ComponentSize() < 4)
+        if (_opt == 3 && vi.ComponentSize() < 4 && !_compact)
             env->ThrowError("vsTTempSmooth: pmode=1 opt=3 supports only 32-bit bit depth.");
     }
 
-    if (_opt == 3)
+    // only the AVX2 and AVX-512 code give the same output (C++ and SSE2 round differently, and so does the float scene change metric)
+    if (_opt < 3 || (vi.ComponentSize() == 4 && (_scthresh || (scfile[0] && _scfilemode == 1))))
+        tune_opt = false;
+
+    if (_compact)
     {
-        switch (vi.ComponentSize())
-        {
-            case 1: compare = ComparePlane_avx512<uint8_t>; break;
-            case 2: compare = ComparePlane_avx512<uint16_t>; break;
-            default:
-            {
-                compare = ComparePlane_avx512<float>;
-                if (_pmode == 1)
-                    filter_mode2 = &TTempSmooth::filterF_mode2_avx512;
-            }
-        }
+        _vi_compact = vi;
+        _vi_compact.pixel_type = (vi.pixel_type & ~VideoInfo::CS_Sample_Bits_Mask) | VideoInfo::CS_Sample_Bits_8;
+        _compact_shift = _shift;
+        // the kernels and the scene change detection work on the 8-bit window
+        _shift = 0;
+        _sc_bits = 8;
     }
-    else if (_opt == 2)
-    {
-        switch (vi.ComponentSize())
-        {
-            case 1:
-            {
+
+    const int l2{ cache_size(2) };
+    _l2 = (l2 > 0) ? l2 : 262144;
+
+    // the C++ code ignores tile
+    if (_pmode == 1)
+        _tile = 0;
+    else if (_tile == -1)
+        // current and prefetched next row of every window stream have to fit in half of L2
+        _tile = std::max((_l2 / 2 / (2 * ((pfclip) ? 2 : 1) * _diameter * vi.ComponentSize())) & ~63, 64);
+    else if (_tile > 0)
+        _tile = (_tile + 63) & ~63;
+
+    // IIR state of pmode=1 and recursive requires frames in order, one at a time
+    if (_pmode == 1 || _recursive)
+        _batch = 1;
+    else
+        _ahead.resize(_batch);
+
+    // distinct frames of a span
+    const int window_size{ _bmaxr + _fmaxr + _batch };
+    _window.assign(window_size, { -1, nullptr });
+
+    // the compact window must not be held at full precision by the cache
+    if (!_compact)
+        child->SetCacheHints(CACHE_WINDOW, window_size);
+
+    if (pfclip)
+    {
+        _window_pf.resize(window_size);
+
+        if (!_compact)
+            _pfclip->SetCacheHints(CACHE_WINDOW, window_size);
+    }
+
+    // twice the pairs of a batch span so a window never evicts its own pairs
+    size_t sc_cache_size{ 1 };
+    while (sc_cache_size < static_cast<size_t>(2 * (_diameter + _batch)))
+        sc_cache_size <<= 1;
+    _sc_cache.assign(sc_cache_size, { -1, 0.0f });
+
+    if (_scstep > 1)
+    {
+        _sc_thumbs.assign(sc_cache_size, { -1, nullptr });
+
+        switch ((_compact) ? 1 : vi.ComponentSize())
+        {
+            case 1: thumbnail = ThumbnailPlane<uint8_t>; break;
+            case 2: thumbnail = ThumbnailPlane<uint16_t>; break;
+            default: thumbnail = ThumbnailPlane<float>;
+        }
+    }
+
+    // the luma decision is only needed when a chroma plane is filtered
+    if (_chromaguide && proccesplanes[1] != 3 && proccesplanes[2] != 3)
+        _chromaguide = false;
+
+    if (_chromaguide)
+    {
+        for (int i{ 1 }; i < 3; ++i)
+        {
+            // indexed by the luma difference, scaled to the plane's thresh
+            if (proccesplanes[i] == 3 && _thresh[i] > _mdiff[i] + 1)
+            {
+                const std::vector<float> weight{ _weight[i] };
+
+                for (int j{ 0 }; j < _maxr; ++j)
+                {
+                    for (int v{ 0 }; v < 256; ++v)
+                        _weight[i][256 * j + v] = weight[256 * j + std::min(v * _thresh[i] / _thresh[0], 255)];
+                }
+            }
+        }
+
+        _guides.resize((luma_guide_size() + chroma_guide_size()) * _batch);
+    }
+
+    select_kernels();
+
+    if (has_at_least_v8)
+    {
+        const auto status = [&](const void* p, const size_t size)
+        {
+            const int s{ huge_page_status(p, size) };
+
+            if (s >= 0)
+                _huge_pages = (_huge_pages < 0) ? s : std::min(_huge_pages, s);
+        };
+
+        for (int i{ 0 }; i < 3; ++i)
+        {
+            status(pIIRMem[i].data(), pIIRMem[i].size());
+            status(pMinSumMem[i].data(), pMinSumMem[i].size() * sizeof(int));
+            status(pMinSumMemF[i].data(), pMinSumMemF[i].size() * sizeof(float));
+        }
+
+        status(_guides.data(), _guides.size() * sizeof(uint32_t));
+    }
+
+    if (tune_opt || tune_threads)
+        tune(tune_opt, tune_threads, env);
+
+#ifdef _DEBUG
+    iMEL_non_current_samples = 0;
+    iMEL_mem_hits = 0;
+    iMEL_mem_updates = 0;
+#endif
+
+    if (scfile[0])
+    {
+        const ScFileHeader header{ { scfile_magic[0], scfile_magic[1], scfile_magic[2], scfile_magic[3], scfile_magic[4], scfile_magic[5], scfile_magic[6], scfile_magic[7] },
+            scfile_version, vi.num_frames, vi.width, vi.height, _sc_bits, _scstep, 0 };
+        bool resized;
+
+        _scfile_size = sizeof(ScFileHeader) + vi.num_frames * sizeof(float);
+        _scfile_view = map_scfile(scfile, _scfile_size, _scfilemode == 1, resized);
+
+        if (!_scfile_view)
+            env->ThrowError("vsTTempSmooth: cannot %s scfile %s.", (_scfilemode == 1) ? "create" : "open", scfile);
+
+        _scfile = reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(_scfile_view) + sizeof(ScFileHeader));
+
+        // the content is compared at the first request (check_scfile)
+        if (memcmp(_scfile_view, &header, offsetof(ScFileHeader, fingerprint)))
+        {
+            // a file of another clip is started over when writing; pairs already written by another instance are kept
+            if (_scfilemode == 0)
+            {
+                unmap_scfile(_scfile_view, _scfile_size);
+                env->ThrowError("vsTTempSmooth: scfile %s was written for a different clip or scstep.", scfile);
+            }
+
+            resized = true;
+        }
+
+        if (resized)
+        {
+            memcpy(_scfile_view, &header, sizeof(ScFileHeader));
+            std::fill_n(_scfile, vi.num_frames, std::numeric_limits<float>::quiet_NaN());
+        }
+    }
+}
+
+template <bool pfclip, bool fp>
+TTempSmooth<pfclip, fp>::~TTempSmooth()
+{
+    if (_lookahead_task.valid())
+        _lookahead_task.wait();
+
+    if (_scfile_view)
+        unmap_scfile(_scfile_view, _scfile_size);
+}
+
+template <bool pfclip, bool fp>
+void TTempSmooth<pfclip, fp>::select_kernels() noexcept
+{
+    filter_mode2 = nullptr;
+
+    if (_opt == 3)
+    {
+        switch (vi.ComponentSize())
+        {
+            case 1: compare = ComparePlane_avx512<uint8_t>; break;
+            case 2: compare = ComparePlane_avx512<uint16_t>; break;
+            default:
+            {
+                compare = ComparePlane_avx512<float>;
+                if (_pmode == 1)
+                    filter_mode2 = &TTempSmooth::filterF_mode2_avx512;
+            }
+        }
+    }
+    else if (_opt == 2)
+    {
+        switch (vi.ComponentSize())
+        {
+            case 1:
+            {
                 compare = ComparePlane_avx2<uint8_t>;
                 if (_pmode == 1)
                     filter_mode2 = &TTempSmooth::filterI_mode2_avx2<uint8_t>;
@@ -713,187 +1848,842 @@ TTempSmooth<pfclip, fp>::TTempSmooth(PClip _child, int maxr, int ythresh, int ut
         }
     }
 
-#ifdef _DEBUG
-    iMEL_non_current_samples = 0;
-    iMEL_mem_hits = 0;
-    iMEL_mem_updates = 0;
-#endif
+    if (_compact)
+    {
+        switch (_opt)
+        {
+            case 3: compare = ComparePlane_avx512<uint8_t>; break;
+            case 2: compare = ComparePlane_avx2<uint8_t>; break;
+            default: compare = ComparePlane<uint8_t>;
+        }
+
+        filter_mode2 = (_opt >= 2) ? &TTempSmooth::filterI_mode2_avx2<uint8_t> : &TTempSmooth::filter_mode2_C<uint8_t>;
+    }
+
+    for (int i{ 0 }; i < std::min(vi.NumComponents(), 3); ++i)
+    {
+        if (proccesplanes[i] != 3)
+            continue;
+
+        if (_pmode == 1)
+            continue;
+
+        const bool useDiff{ _thresh[i] > _mdiff[i] + 1 };
+        // only the C and AVX2 luma kernels record the decision for the chroma planes
+        const int opt{ (_chromaguide && i == 0) ? ((_opt >= 2) ? 2 : 0) : _opt };
+
+        switch (vi.ComponentSize())
+        {
+            case 1: filter[i] = (useDiff) ? select_filter<uint8_t, true>(opt) : select_filter<uint8_t, false>(opt); break;
+            case 2: filter[i] = (useDiff) ? select_filter<uint16_t, true>(opt) : select_filter<uint16_t, false>(opt); break;
+            default: filter[i] = (useDiff) ? select_filter<float, true>(opt) : select_filter<float, false>(opt);
+        }
+
+        if (_chromaguide && i > 0)
+        {
+            if (_opt >= 2)
+            {
+                switch (vi.ComponentSize())
+                {
+                    case 1: filter_guided[i] = (useDiff) ? get_filter_guided_avx2<uint8_t, true>() : get_filter_guided_avx2<uint8_t, false>(); break;
+                    case 2: filter_guided[i] = (useDiff) ? get_filter_guided_avx2<uint16_t, true>() : get_filter_guided_avx2<uint16_t, false>(); break;
+                    default: filter_guided[i] = (useDiff) ? get_filter_guided_avx2<float, true>() : get_filter_guided_avx2<float, false>();
+                }
+            }
+            else
+            {
+                switch (vi.ComponentSize())
+                {
+                    case 1: filter_guided[i] = (useDiff) ? &TTempSmooth::filterC_guided<uint8_t, true> : &TTempSmooth::filterC_guided<uint8_t, false>; break;
+                    case 2: filter_guided[i] = (useDiff) ? &TTempSmooth::filterC_guided<uint16_t, true> : &TTempSmooth::filterC_guided<uint16_t, false>; break;
+                    default: filter_guided[i] = (useDiff) ? &TTempSmooth::filterC_guided<float, true> : &TTempSmooth::filterC_guided<float, false>;
+                }
+            }
+        }
+    }
+
+    filter_recursive = nullptr;
+
+    if (_recursive)
+    {
+        switch (vi.ComponentSize())
+        {
+            case 1: filter_recursive = (_opt >= 2) ? &TTempSmooth::filter_recursive_avx2<uint8_t> : &TTempSmooth::filter_recursive_C<uint8_t>; break;
+            case 2: filter_recursive = (_opt >= 2) ? &TTempSmooth::filter_recursive_avx2<uint16_t> : &TTempSmooth::filter_recursive_C<uint16_t>; break;
+            default: filter_recursive = (_opt >= 2) ? &TTempSmooth::filter_recursive_avx2<float> : &TTempSmooth::filter_recursive_C<float>;
+        }
+    }
+
+    filter_uv = nullptr;
 
+    // the fused kernels exist for C and AVX2; the AVX2 one processes whole rows
+    if (_pmode == 0 && !_chromaguide && !_recursive && vi.NumComponents() >= 3 && proccesplanes[1] == 3 && proccesplanes[2] == 3 && (_opt == 0 || (_opt == 2 && _tile == 0)))
+    {
+        const bool useDiff{ _thresh[1] > _mdiff[1] + 1 };
+
+        if (useDiff == (_thresh[2] > _mdiff[2] + 1))
+        {
+            if (_opt == 2)
+            {
+                switch (vi.ComponentSize())
+                {
+                    case 1: filter_uv = (useDiff) ? get_filter_uv_avx2<uint8_t, true>() : get_filter_uv_avx2<uint8_t, false>(); break;
+                    case 2: filter_uv = (useDiff) ? get_filter_uv_avx2<uint16_t, true>() : get_filter_uv_avx2<uint16_t, false>(); break;
+                    default: filter_uv = (useDiff) ? get_filter_uv_avx2<float, true>() : get_filter_uv_avx2<float, false>();
+                }
+            }
+            else
+            {
+                switch (vi.ComponentSize())
+                {
+                    case 1: filter_uv = (useDiff) ? get_filter_uv<uint8_t, true>() : get_filter_uv<uint8_t, false>(); break;
+                    case 2: filter_uv = (useDiff) ? get_filter_uv<uint16_t, true>() : get_filter_uv<uint16_t, false>(); break;
+                    default: filter_uv = (useDiff) ? get_filter_uv<float, true>() : get_filter_uv<float, false>();
+                }
+            }
+        }
+    }
 }
 
 template <bool pfclip, bool fp>
-PVideoFrame __stdcall TTempSmooth<pfclip, fp>::GetFrame(int n, IScriptEnvironment* env)
+void TTempSmooth<pfclip, fp>::tune(const bool tune_opt, const bool tune_threads, IScriptEnvironment* env)
+{
+    // instances with the same format and settings get the same result: every instance of MT_MULTI_INSTANCE would tune on its own
+    // and could pick different code; the lock also keeps concurrent constructors from timing each other
+    static std::mutex tuned_mutex;
+    static std::map<std::vector<int>, std::pair<int, int>> tuned;
+
+    const std::vector<int> key{ vi.pixel_type, vi.width, vi.height, vi.num_frames, _bmaxr, _fmaxr, _thresh[0], _thresh[1], _thresh[2], _mdiff[0], _mdiff[1], _mdiff[2],
+        proccesplanes[0], proccesplanes[1], proccesplanes[2], _pmode, _thUPD[0], _thUPD[1], _thUPD[2], _pnew[0], _pnew[1], _pnew[2], _tile, _batch, _scstep, _scprops,
+        _scthresh > 0.0f, _compact, _chromaguide, _recursive, _opt, _threads, tune_opt, tune_threads };
+
+    std::lock_guard<std::mutex> lock(tuned_mutex);
+
+    if (const auto it{ tuned.find(key) }; it != tuned.end())
+    {
+        _opt = it->second.first;
+        _threads = it->second.second;
+        select_kernels();
+
+        return;
+    }
+
+    const thread_budget::measurement measurement;
+
+    // a few distinct frames repeated over the window; every candidate filters the same data
+    const VideoInfo& vi_window{ (_compact) ? _vi_compact : vi };
+    constexpr int planes_y[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
+    PVideoFrame frames[4];
+
+    for (int k{ 0 }; k < 4; ++k)
+    {
+        frames[k] = env->NewVideoFrame(vi_window);
+
+        for (int i{ 0 }; i < std::min(vi.NumComponents(), 3); ++i)
+        {
+            switch (vi_window.ComponentSize())
+            {
+                case 1: SyntheticPlane<uint8_t>(frames[k], planes_y[i], k, 0); break;
+                case 2: SyntheticPlane<uint16_t>(frames[k], planes_y[i], k, _shift); break;
+                default: SyntheticPlane<float>(frames[k], planes_y[i], k, 0);
+            }
+        }
+    }
+
+    // the full-precision center of the compact window; the clip's frames are never requested while tuning
+    if (_compact)
+    {
+        _tune_center = env->NewVideoFrame(vi);
+
+        for (int i{ 0 }; i < std::min(vi.NumComponents(), 3); ++i)
+            SyntheticPlane<uint16_t>(_tune_center, planes_y[i], 0, _compact_shift);
+    }
+
+    const int n{ std::min(_bmaxr, vi.num_frames - 1) };
+    const int last{ std::min(n + _fmaxr, vi.num_frames - 1) };
+
+    // best time of process_frames(n) with the whole window held; a slow first run (IIR first touch, thread start) is the only one
+    const auto run = [&]()
+    {
+        double best{ std::numeric_limits<double>::max() };
+
+        for (int r{ 0 }; r < 4; ++r)
+        {
+            for (int f{ 0 }; f <= last; ++f)
+            {
+                _window[f % _window.size()] = { f, frames[f & 3] };
+
+                if constexpr (pfclip)
+                    _window_pf[f % _window_pf.size()] = frames[(f + 1) & 3];
+            }
+
+            _sc_cache.assign(_sc_cache.size(), { -1, 0.0f });
+            _sc_thumbs.assign(_sc_thumbs.size(), { -1, nullptr });
+
+            const auto start{ std::chrono::steady_clock::now() };
+            process_frames(n, 1, env);
+            const double time{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+
+            if (r == 0 && time > 0.25)
+                return time;
+            if (r > 0)
+                best = std::min(best, time);
+        }
+
+        return best;
+    };
+
+    if (tune_opt)
+    {
+        int best_opt{ _opt };
+        double best{ std::numeric_limits<double>::max() };
+
+        for (int opt{ 2 }; opt <= 3; ++opt)
+        {
+            _opt = opt;
+            select_kernels();
+            const double time{ run() };
+
+            if (time < best)
+            {
+                best = time;
+                best_opt = opt;
+            }
+        }
+
+        _opt = best_opt;
+        select_kernels();
+    }
+
+    // threads are used by pmode=1 and the scene change detection only
+    if (tune_threads)
+    {
+        const int cpus{ _threads };
+
+        if (_pmode == 1 || _recursive || (_scthresh && vi.width * vi.height >= sc_parallel_pixels))
+        {
+            _threads = 1;
+            double best{ run() };
+
+            // another doubling has to gain at least 10% to be worth the threads it takes from other instances
+            for (int threads{ 2 }; threads < 2 * cpus; threads *= 2)
+            {
+                const int t{ std::min(threads, cpus) };
+                const int previous{ _threads };
+                _threads = t;
+                const double time{ run() };
+
+                if (time < best * 0.9)
+                    best = time;
+                else
+                {
+                    _threads = previous;
+                    break;
+                }
+            }
+        }
+        else
+            _threads = 1;
+    }
+
+    // the synthetic frames and their state must not reach the clip's frames
+    _tune_center = nullptr;
+    _window.assign(_window.size(), { -1, nullptr });
+
+    if constexpr (pfclip)
+        _window_pf.assign(_window_pf.size(), nullptr);
+
+    _sc_cache.assign(_sc_cache.size(), { -1, 0.0f });
+    _sc_thumbs.assign(_sc_thumbs.size(), { -1, nullptr });
+    std::fill_n(_iir_touched, 3, false);
+    _recursive_n = -1;
+
+    tuned.emplace(key, std::make_pair(_opt, _threads));
+}
+
+template <bool pfclip, bool fp>
+void TTempSmooth<pfclip, fp>::check_scfile(IScriptEnvironment* env)
+{
+    // the frames compared for scene changes, at full precision
+    const PClip& clip{ (pfclip) ? _pfclip : child };
+    uint64_t fingerprint{ 0xcbf29ce484222325 };
+
+    for (const int f : { 0, vi.num_frames / 2, vi.num_frames - 1 })
+        fingerprint = HashPlane(clip->GetFrame(f, env), fingerprint);
+
+    auto& header{ *reinterpret_cast<ScFileHeader*>(_scfile_view) };
+
+    if (header.fingerprint == fingerprint)
+        return;
+
+    if (_scfilemode == 0)
+        env->ThrowError("vsTTempSmooth: scfile was written for a different clip (the frames don't match).");
+
+    std::fill_n(_scfile, vi.num_frames, std::numeric_limits<float>::quiet_NaN());
+    header.fingerprint = fingerprint;
+}
+
+template <bool pfclip, bool fp>
+std::shared_ptr<const std::vector<float>> TTempSmooth<pfclip, fp>::sc_thumb(const int f, PVideoFrame& src)
+{
+    auto& entry{ _sc_thumbs[f & (_sc_thumbs.size() - 1)] };
+
+    {
+        std::lock_guard<std::mutex> lock(_sc_mutex);
+
+        if (entry.first == f)
+            return entry.second;
+    }
+
+    auto thumb{ std::make_shared<std::vector<float>>() };
+    thumbnail(src, _scstep, *thumb);
+
+    std::lock_guard<std::mutex> lock(_sc_mutex);
+    entry = { f, thumb };
+
+    return thumb;
+}
+
+template <bool pfclip, bool fp>
+float TTempSmooth<pfclip, fp>::sc_metric(const int f, PVideoFrame& src, PVideoFrame& src1)
 {
-    PVideoFrame src[MAX_TEMP_RAD * 2 + 1] = {};
-    PVideoFrame pf[MAX_TEMP_RAD * 2 + 1] = {};
+    // no pixel reads for pairs of the stats file
+    if (_scfile && _scfilemode == 0 && !std::isnan(_scfile[f]))
+        return _scfile[f];
+
+    auto& entry{ _sc_cache[f & (_sc_cache.size() - 1)] };
+
+    {
+        std::lock_guard<std::mutex> lock(_sc_mutex);
+
+        if (entry.first == f)
+            return entry.second;
+    }
+
+    float metric;
 
-    for (int i{ n - _maxr }; i <= n + _maxr; ++i)
+    if (_scstep > 1)
     {
-        const int frameNumber{ std::clamp(i, 0, vi.num_frames - 1) };
+        const auto thumb{ sc_thumb(f, src) };
+        const auto thumb1{ sc_thumb(f + 1, src1) };
+        const float peak{ (vi.ComponentSize() < 4) ? static_cast<float>((1 << _sc_bits) - 1) : 1.0f };
+        float sad{ 0.0f };
 
-        src[i - n + _maxr] = child->GetFrame(frameNumber, env);
+        for (size_t i{ 0 }; i < thumb->size(); ++i)
+            sad += std::abs((*thumb)[i] - (*thumb1)[i]);
+
+        metric = sad / (peak * _scstep * _scstep * thumb->size());
+    }
+    else
+        // the stats file needs the metric exact for any scthresh
+        metric = compare(src, src1, _sc_bits, (_scfile && _scfilemode == 1) ? 1.0f : _scthresh / 100.f);
+
+    std::lock_guard<std::mutex> lock(_sc_mutex);
+    entry = { f, metric };
+
+    if (_scfile && _scfilemode == 1)
+        _scfile[f] = metric;
+
+    return metric;
+}
+
+template <bool pfclip, bool fp>
+PVideoFrame TTempSmooth<pfclip, fp>::compact_frame(PVideoFrame& src, IScriptEnvironment* env)
+{
+    // the properties are kept for scprops
+    PVideoFrame dst{ (has_at_least_v8) ? env->NewVideoFrameP(_vi_compact, &src) : env->NewVideoFrame(_vi_compact) };
+
+    constexpr int planes_y[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
+    for (int i{ 0 }; i < std::min(vi.NumComponents(), 3); ++i)
+    {
+        // luma is compared for scene changes
+        if (i == 0 || proccesplanes[i] == 3)
+            CompactPlane(src, dst, planes_y[i], _compact_shift);
+    }
+
+    return dst;
+}
+
+template <bool pfclip, bool fp>
+void TTempSmooth<pfclip, fp>::fetch_frame(const int f, PVideoFrame& frame, PVideoFrame& frame_pf, IScriptEnvironment* env)
+{
+    PVideoFrame src{ child->GetFrame(f, env) };
+    frame = (_compact) ? compact_frame(src, env) : src;
+
+    if constexpr (pfclip)
+    {
+        PVideoFrame src_pf{ _pfclip->GetFrame(f, env) };
+        frame_pf = (_compact) ? compact_frame(src_pf, env) : src_pf;
+    }
+}
+
+template <bool pfclip, bool fp>
+bool TTempSmooth<pfclip, fp>::look_ahead(const int n, const int count, IScriptEnvironment* env)
+{
+    // a spare thread of the budget; without one the next request compares the frames as usual
+    auto budget{ std::make_shared<thread_budget>(2) };
+
+    if (budget->threads() < 2)
+        return false;
+
+    const int span{ _diameter + count - 1 };
+    const int last{ window_frame(n, count, span - 1) };
+    const int next_last{ window_frame(n + count, _batch, _diameter + _batch - 2) };
+
+    if (next_last <= last)
+        return false;
+
+    // the frames of this window first and the new ones of the next in order, so the source filters still see sequential requests
+    for (int i{ 0 }; i < span; ++i)
+    {
+        const int frameNumber{ window_frame(n, count, i) };
+        const size_t slot{ frameNumber % _window.size() };
+
+        {
+            std::lock_guard<std::mutex> lock(_window_mutex);
+
+            if (_window[slot].first == frameNumber)
+                continue;
+        }
+
+        PVideoFrame src, pf;
+        fetch_frame(frameNumber, src, pf, env);
+
+        std::lock_guard<std::mutex> lock(_window_mutex);
+        _window[slot] = { frameNumber, src };
 
         if constexpr (pfclip)
-            pf[i - n + _maxr] = _pfclip->GetFrame(frameNumber, env);
+            _window_pf[slot] = pf;
+    }
+
+    // kept out of the window until this request is done, their slots hold frames of this window
+    _lookahead_first = last + 1;
+    _lookahead_frames.resize(next_last - last);
+
+    for (int f{ last + 1 }; f <= next_last; ++f)
+        fetch_frame(f, _lookahead_frames[f - last - 1].first, _lookahead_frames[f - last - 1].second, env);
+
+    // the frames compared for scene changes; env and the source filters are only used by the calling thread
+    auto frames{ std::make_shared<std::vector<PVideoFrame>>() };
+
+    {
+        std::lock_guard<std::mutex> lock(_window_mutex);
+        const size_t slot{ last % _window.size() };
+        frames->emplace_back((pfclip) ? _window_pf[slot] : _window[slot].second);
     }
 
-    PVideoFrame dst{ (has_at_least_v8) ? env->NewVideoFrameP(vi, &src[_maxr]) : env->NewVideoFrame(vi) };
+    for (auto& frame : _lookahead_frames)
+        frames->emplace_back((pfclip) ? frame.second : frame.first);
+
+    // only the pairs of the new frames; this window's pairs are compared by process_frames at the same time
+    _lookahead_task = std::async(std::launch::async, [this, budget, frames, last]()
+        {
+            for (size_t i{ 0 }; i < frames->size() - 1; ++i)
+                sc_metric(last + static_cast<int>(i), (*frames)[i], (*frames)[i + 1]);
+        });
+
+    return true;
+}
+
+template <bool pfclip, bool fp>
+PVideoFrame TTempSmooth<pfclip, fp>::process_frames(const int n, const int count, IScriptEnvironment* env)
+{
+    PVideoFrame src[MAX_TEMP_RAD * 2 + MAX_BATCH] = {};
+    PVideoFrame pf[MAX_TEMP_RAD * 2 + MAX_BATCH] = {};
+    const int span{ _diameter + count - 1 };
 
-    int fromFrame{ -1 };
-    int toFrame{ _diameter };
-    const int bits_per_pixel{ vi.BitsPerComponent() };
+    // frames of the span not held from the last windows; clamped duplicates are adjacent
+    int missing[MAX_TEMP_RAD * 2 + MAX_BATCH];
+    int num_missing{ 0 };
+
+    // without the window table (overlapping MT_NICE_FILTER requests) the whole span is requested; the cache after the child holds it
+    const bool bypass{ _window_bypass.load(std::memory_order_relaxed) };
 
-    if (_scthresh)
     {
-        for (int i{ _maxr }; i > 0; --i)
+        // the window table is shared by the threads of MT_NICE_FILTER
+        std::unique_lock<std::mutex> lock(_window_mutex, std::defer_lock);
+
+        if (!bypass)
+            lock.lock();
+
+        for (int i{ 0 }; i < span; ++i)
         {
-            if (compare((pfclip) ? pf[i - 1] : src[i - 1], (pfclip) ? pf[i] : src[i], bits_per_pixel) > _scthresh / 100.f)
+            const int frameNumber{ window_frame(n, count, i) };
+            const size_t slot{ frameNumber % _window.size() };
+
+            if (!bypass && _window[slot].first == frameNumber)
             {
-                fromFrame = i;
-                break;
+                src[i] = _window[slot].second;
+
+                if constexpr (pfclip)
+                    pf[i] = _window_pf[slot];
+            }
+            else if (num_missing == 0 || missing[num_missing - 1] != frameNumber)
+                missing[num_missing++] = frameNumber;
+        }
+    }
+
+    PVideoFrame fetched[MAX_TEMP_RAD * 2 + MAX_BATCH];
+    PVideoFrame fetched_pf[MAX_TEMP_RAD * 2 + MAX_BATCH];
+
+    // requested on the calling thread only: a worker thread has no IScriptEnvironment of its own,
+    // and MTGuard, which picks the upstream instance by env, isn't reentrant
+    for (int j{ 0 }; j < num_missing; ++j)
+        fetch_frame(missing[j], fetched[j], fetched_pf[j], env);
+
+    if (num_missing > 0 && !bypass)
+    {
+        std::lock_guard<std::mutex> lock(_window_mutex);
+
+        // the table may have been given up while the frames were fetched
+        if (!_window_bypass.load(std::memory_order_relaxed))
+        {
+            // every frame has its own slot
+            for (int j{ 0 }; j < num_missing; ++j)
+            {
+                _window[missing[j] % _window.size()] = { missing[j], fetched[j] };
+
+                if constexpr (pfclip)
+                    _window_pf[missing[j] % _window_pf.size()] = fetched_pf[j];
             }
         }
+    }
+
+    // missing is ascending like the span
+    for (int i{ 0 }, j{ 0 }; i < span; ++i)
+    {
+        if (src[i])
+            continue;
+
+        const int frameNumber{ window_frame(n, count, i) };
+
+        while (missing[j] != frameNumber)
+            ++j;
+
+        src[i] = fetched[j];
 
-        for (int i{ _maxr }; i < _diameter - 1; ++i)
+        if constexpr (pfclip)
+            pf[i] = fetched_pf[j];
+    }
+
+    // output frame and the source of the copied planes at full precision
+    PVideoFrame center;
+    PVideoFrame center_pf;
+
+    if (_compact)
+    {
+        center = (_tune_center) ? _tune_center : child->GetFrame(n, env);
+
+        if constexpr (pfclip)
+            center_pf = (_tune_center) ? _tune_center : _pfclip->GetFrame(n, env);
+    }
+
+    // pmode=1 compares every pair of the window within the radii; copies of a clamped edge frame are compared once
+    window_slots win;
+
+    if (_pmode == 1)
+    {
+        win.num = 0;
+
+        for (int i{ _maxr - _bmaxr }; i <= _maxr + _fmaxr; ++i)
         {
-            if (compare((pfclip) ? pf[i] : src[i], (pfclip) ? pf[i + 1] : src[i + 1], bits_per_pixel) > _scthresh / 100.f)
+            const int frameNumber{ window_frame(n, 1, i) };
+
+            if (i != _maxr && i - 1 != _maxr && win.num > 0 && window_frame(n, 1, i - 1) == frameNumber)
+                ++win.mult[win.num - 1];
+            else
             {
-                toFrame = i;
-                break;
+                win.slot[win.num] = i;
+                win.mult[win.num++] = 1;
+            }
+        }
+    }
+
+    // scene change between frames i and i + 1 of the span; -1: not compared yet
+    int sc[MAX_TEMP_RAD * 2 + MAX_BATCH - 1];
+    std::fill_n(sc, span - 1, -1);
+
+    const auto is_sc = [&](const int i)
+    {
+        if (sc[i] < 0)
+        {
+            const int f{ window_frame(n, count, i) };
+
+            // both frames of the pair are the same clamped edge frame
+            if (f == window_frame(n, count, i + 1))
+                sc[i] = 0;
+            else
+            {
+                if (_scprops & 1)
+                {
+                    // a decision of an upstream scene change detector on either frame of the pair
+                    int err;
+                    int64_t prop{ env->propGetInt(env->getFramePropsRO(src[i]), "_SceneChangeNext", 0, &err) };
+
+                    if (err)
+                        prop = env->propGetInt(env->getFramePropsRO(src[i + 1]), "_SceneChangePrev", 0, &err);
+                    if (!err)
+                        sc[i] = prop != 0;
+                }
+
+                if (sc[i] < 0)
+                    sc[i] = (_scthresh) ? sc_metric(f, (pfclip) ? pf[i] : src[i], (pfclip) ? pf[i + 1] : src[i + 1]) > _scthresh / 100.f : 0;
+            }
+        }
+
+        return sc[i] == 1;
+    };
+
+    // the pairs of the span not compared yet are compared at once instead of one after another up to the first scene change;
+    // a sequential request has one new pair, it stays on the calling thread like the pairs of small frames
+    if (_threads > 1 && _scthresh && vi.width * vi.height >= sc_parallel_pixels)
+    {
+        int pending[MAX_TEMP_RAD * 2 + MAX_BATCH - 1];
+        int num_pending{ 0 };
+
+        {
+            std::lock_guard<std::mutex> lock(_sc_mutex);
+
+            for (int i{ 0 }; i < span - 1; ++i)
+            {
+                const int f{ window_frame(n, count, i) };
+
+                if (f != window_frame(n, count, i + 1) && !(_scfile && _scfilemode == 0 && !std::isnan(_scfile[f])) && _sc_cache[f & (_sc_cache.size() - 1)].first != f)
+                    pending[num_pending++] = i;
             }
         }
+
+        if (num_pending > 1)
+        {
+            const thread_budget budget(std::min(_threads, num_pending));
+
+#pragma omp parallel for num_threads(budget.threads())
+            for (int j = 0; j < num_pending; ++j)
+                is_sc(pending[j]);
+        }
     }
 
+    PVideoFrame dst[MAX_BATCH] = {};
+    int fromFrame[MAX_BATCH];
+    int toFrame[MAX_BATCH];
+
+    for (int b{ 0 }; b < count; ++b)
+    {
+        dst[b] = (has_at_least_v8) ? env->NewVideoFrameP(vi, (_compact) ? &center : &src[b + _maxr]) : env->NewVideoFrame(vi);
+        // the frames just outside the radii bound the kernels like a scene change
+        fromFrame[b] = _maxr - _bmaxr - 1;
+        toFrame[b] = _maxr + _fmaxr + 1;
+
+        // the stats file gets the pair after every output frame whether or not a decision needs it; the pair before without frames ahead
+        if (_scfile && _scfilemode == 1)
+        {
+            if (_fmaxr > 0 && n + b + 1 < vi.num_frames)
+                sc_metric(n + b, (pfclip) ? pf[b + _maxr] : src[b + _maxr], (pfclip) ? pf[b + _maxr + 1] : src[b + _maxr + 1]);
+            else if (_fmaxr == 0 && n + b > 0)
+                sc_metric(n + b - 1, (pfclip) ? pf[b + _maxr - 1] : src[b + _maxr - 1], (pfclip) ? pf[b + _maxr] : src[b + _maxr]);
+        }
+
+        if (_scthresh || (_scprops & 1))
+        {
+            for (int i{ _maxr }; i > _maxr - _bmaxr; --i)
+            {
+                if (is_sc(b + i - 1))
+                {
+                    fromFrame[b] = i;
+                    break;
+                }
+            }
+
+            for (int i{ _maxr }; i < _maxr + _fmaxr; ++i)
+            {
+                if (is_sc(b + i))
+                {
+                    toFrame[b] = i;
+                    break;
+                }
+            }
+        }
+
+        if (_scprops & 2)
+        {
+            AVSMap* props{ env->getFramePropsRW(dst[b]) };
+            env->propSetInt(props, "_SceneChangePrev", is_sc(b + _maxr - 1), 0);
+
+            // unknown without the next frame
+            if (_fmaxr > 0)
+                env->propSetInt(props, "_SceneChangeNext", is_sc(b + _maxr), 0);
+        }
+
+        if (_huge_pages >= 0)
+            env->propSetInt(env->getFramePropsRW(dst[b]), "TTempSmoothHugePages", _huge_pages, 0);
+    }
+
+    // chromaguide: the record of the luma kernel for every output, followed by its subsampled copies for the chroma planes
+    uint32_t* const guides{ _guides.data() };
+    const size_t luma_guide{ (_chromaguide) ? luma_guide_size() : 0 };
+    const size_t chroma_guide{ (_chromaguide) ? chroma_guide_size() : 0 };
+
+    // the recursive state continues only from the frame before
+    const int recursive_from{ (_recursive_n < 0 || n != _recursive_n + 1) ? _maxr : fromFrame[0] };
+
     constexpr int planes_y[3] = { PLANAR_Y, PLANAR_U, PLANAR_V };
     for (int i{ 0 }; i < std::min(vi.NumComponents(), 3); ++i)
     {
         if (proccesplanes[i] == 3)
         {
-            if (_pmode == 1)
+            if (_recursive)
             {
-                (this->*filter_mode2)(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
+                (this->*filter_recursive)(src, (pfclip) ? pf : src, dst[0], recursive_from, toFrame[0], planes_y[i]);
                 continue;
             }
 
-            if (_opt == 3)
+            if (_pmode == 1)
             {
-                switch (vi.ComponentSize())
+                if (_compact)
                 {
-                    case 1:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterI_avx512<uint8_t, true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterI_avx512<uint8_t, false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        break;
-                    }
-                    case 2:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterI_avx512<uint16_t, true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterI_avx512<uint16_t, false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        break;
-                    }
-                    default:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterF_avx512<true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterF_avx512<false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                    }
+                    // the kernel outputs the window sample or the pfclip center
+                    PVideoFrame dst8{ env->NewVideoFrame(_vi_compact) };
+                    (this->*filter_mode2)(src, (pfclip) ? pf : src, dst8, fromFrame[0], toFrame[0], planes_y[i], win);
+                    ExpandPlane(dst8, (pfclip) ? pf[_maxr] : src[_maxr], (pfclip) ? center_pf : center, dst[0], planes_y[i], _compact_shift, _threads);
                 }
+                else
+                    (this->*filter_mode2)(src, (pfclip) ? pf : src, dst[0], fromFrame[0], toFrame[0], planes_y[i], win);
+
+                continue;
             }
-            else if (_opt == 2)
+
+            // rows of all span frames of a band have to fit in half of L2 so every output of the batch reads them from cache
+            const int height{ dst[0]->GetHeight(planes_y[i]) };
+            const int band{ (count > 1) ? std::max(_l2 / 2 / (span * ((pfclip) ? 2 : 1) * ((filter_uv && i > 0) ? 2 : 1) * src[0]->GetRowSize(planes_y[i])), 1) : height };
+
+            if (filter_uv && i == 1)
             {
-                switch (vi.ComponentSize())
+                for (int y0{ 0 }; y0 < height; y0 += band)
                 {
-                    case 1:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterI_avx2<uint8_t, true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterI_avx2<uint8_t, false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        break;
-                    }
-                    case 2:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterI_avx2<uint16_t, true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterI_avx2<uint16_t, false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        break;
-                    }
-                    default:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterF_avx2<true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterF_avx2<false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                    }
+                    for (int b{ 0 }; b < count; ++b)
+                        (this->*filter_uv)(src + b, ((pfclip) ? pf : src) + b, dst[b], fromFrame[b], toFrame[b], y0, std::min(y0 + band, height));
                 }
+
+                // V is done too
+                break;
             }
-            else if (_opt == 1)
+
+            for (int y0{ 0 }; y0 < height; y0 += band)
             {
-                switch (vi.ComponentSize())
+                for (int b{ 0 }; b < count; ++b)
                 {
-                    case 1:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterI_sse2<uint8_t, true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterI_sse2<uint8_t, false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        break;
-                    }
-                    case 2:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterI_sse2<uint16_t, true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterI_sse2<uint16_t, false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        break;
-                    }
-                    default:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterF_sse2<true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterF_sse2<false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                    }
+                    if (_chromaguide && i > 0)
+                        (this->*filter_guided[i])(src + b, ((pfclip) ? pf : src) + b, dst[b], guides + luma_guide * count + chroma_guide * b, planes_y[i], y0, std::min(y0 + band, height));
+                    else
+                        (this->*filter[i])(src + b, ((pfclip) ? pf : src) + b, dst[b], fromFrame[b], toFrame[b], planes_y[i], y0, std::min(y0 + band, height), (_chromaguide && i == 0) ? guides + luma_guide * b : nullptr);
                 }
             }
-            else
+
+            if (_chromaguide && i == 0)
             {
-                switch (vi.ComponentSize())
-                {
-                    case 1:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterI<uint8_t, true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterI<uint8_t, false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        break;
-                    }
-                    case 2:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterI<uint16_t, true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterI<uint16_t, false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        break;
-                    }
-                    default:
-                    {
-                        if (_thresh[i] > _mdiff[i] + 1)
-                            TTempSmooth::filterF<true>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                        else
-                            TTempSmooth::filterF<false>(src, (pfclip) ? pf : src, dst, fromFrame, toFrame, planes_y[i]);
-                    }
-                }
+                const int width{ src[0]->GetRowSize(PLANAR_U) / vi.ComponentSize() };
+
+                for (int b{ 0 }; b < count; ++b)
+                    SubsampleGuide(guides + luma_guide * b, guides + luma_guide * count + chroma_guide * b, width, src[0]->GetHeight(PLANAR_U), guide_stride(vi.width), guide_stride(width),
+                        vi.GetPlaneWidthSubsampling(PLANAR_U), vi.GetPlaneHeightSubsampling(PLANAR_U));
             }
         }
         else if (proccesplanes[i] == 2)
-            env->BitBlt(dst->GetWritePtr(planes_y[i]), dst->GetPitch(planes_y[i]), src[_maxr]->GetReadPtr(planes_y[i]), src[_maxr]->GetPitch(planes_y[i]), src[_maxr]->GetRowSize(planes_y[i]), src[_maxr]->GetHeight(planes_y[i]));
+        {
+            for (int b{ 0 }; b < count; ++b)
+            {
+                const PVideoFrame& copy{ (_compact) ? center : src[b + _maxr] };
+                env->BitBlt(dst[b]->GetWritePtr(planes_y[i]), dst[b]->GetPitch(planes_y[i]), copy->GetReadPtr(planes_y[i]), copy->GetPitch(planes_y[i]), copy->GetRowSize(planes_y[i]), copy->GetHeight(planes_y[i]));
+            }
+        }
+    }
+
+    if (_recursive)
+        _recursive_n = n;
+
+    if (count > 1)
+    {
+        _ahead_first = n;
+        _ahead[0] = nullptr;
+
+        for (int b{ 1 }; b < _batch; ++b)
+            _ahead[b] = (b < count) ? dst[b] : nullptr;
+    }
+
+    return dst[0];
+}
+
+template <bool pfclip, bool fp>
+PVideoFrame __stdcall TTempSmooth<pfclip, fp>::GetFrame(int n, IScriptEnvironment* env)
+{
+    const thread_budget::caller caller;
+
+    if (_scfile)
+        std::call_once(_scfile_checked, [&]() { check_scfile(env); });
+
+    if (_batch == 1 && !_lookahead)
+    {
+        struct request
+        {
+            std::atomic<int>& requests;
+            ~request() { --requests; }
+        };
+
+        const bool overlapping{ ++_requests > 1 };
+        const request done{ _requests };
+
+        // MT_NICE_FILTER: the windows of the threads span more frames than the table has slots and would evict each other's, so it's given up
+        // for good and its frames released
+        if (overlapping && !_window_bypass.exchange(true))
+        {
+            std::lock_guard<std::mutex> lock(_window_mutex);
+            _window.assign(_window.size(), { -1, nullptr });
+
+            if constexpr (pfclip)
+                _window_pf.assign(_window_pf.size(), nullptr);
+        }
+
+        return process_frames(n, 1, env);
+    }
+
+    // the background work writes the caches this request reads; its errors are raised here
+    if (_lookahead_task.valid())
+        _lookahead_task.get();
+
+    const bool sequential{ n == _last_n + 1 };
+    _last_n = n;
+
+    const int i{ n - _ahead_first };
+
+    if (_batch > 1 && i >= 0 && i < _batch && _ahead[i])
+    {
+        PVideoFrame dst{ _ahead[i] };
+        _ahead[i] = nullptr;
+
+        return dst;
+    }
+
+    // a batch only pays off when the following frames are requested next
+    const int count{ (sequential) ? std::min(_batch, vi.num_frames - n) : 1 };
+    // only the scene change metrics are worth computing ahead
+    const bool ahead{ _lookahead && sequential && n + count < vi.num_frames && (_scthresh || (_scfile && _scfilemode == 1)) && look_ahead(n, count, env) };
+    PVideoFrame dst{ process_frames(n, count, env) };
+
+    if (ahead)
+    {
+        std::lock_guard<std::mutex> lock(_window_mutex);
+
+        for (int j{ 0 }; j < static_cast<int>(_lookahead_frames.size()); ++j)
+        {
+            const int frameNumber{ _lookahead_first + j };
+            const size_t slot{ frameNumber % _window.size() };
+            _window[slot] = { frameNumber, _lookahead_frames[j].first };
+
+            if constexpr (pfclip)
+                _window_pf[slot] = _lookahead_frames[j].second;
+        }
+
+        _lookahead_frames.clear();
     }
 
     return dst;
@@ -901,7 +2691,7 @@ PVideoFrame __stdcall TTempSmooth<pfclip, fp>::GetFrame(int n, IScriptEnvironmen
 
 AVSValue __cdecl Create_TTempSmooth(AVSValue args, void* user_data, IScriptEnvironment* env)
 {
-    enum { Clip, Maxr, Ythresh, Uthresh, Vthresh, Ymdiff, Umdiff, Vmdiff, Strength, Scthresh, Fp, Y, U, V, Pfclip, Opt, Pmode, YthUPD, UthUPD, VthUPD, Ypnew, Upnew, Vpnew, Threads };
+    enum { Clip, Maxr, Ythresh, Uthresh, Vthresh, Ymdiff, Umdiff, Vmdiff, Strength, Scthresh, Fp, Y, U, V, Pfclip, Opt, Pmode, YthUPD, UthUPD, VthUPD, Ypnew, Upnew, Vpnew, Threads, Tile, Batch, Scstep, Scprops, Scfile, Scfilemode, Compact, Chromaguide, Lookahead, Recursive, Fmaxr };
 
     PClip pfclip{ (args[Pfclip].Defined() ? args[Pfclip].AsClip() : nullptr) };
     const bool fp{ args[Fp].AsBool(true) };
@@ -933,6 +2723,17 @@ AVSValue __cdecl Create_TTempSmooth(AVSValue args, void* user_data, IScriptEnvir
                 args[Upnew].AsInt(0),
                 args[Vpnew].AsInt(0),
                 args[Threads].AsInt(1),
+                args[Tile].AsInt(0),
+                args[Batch].AsInt(1),
+                args[Scstep].AsInt(1),
+                args[Scprops].AsInt(0),
+                args[Scfile].AsString(""),
+                args[Scfilemode].AsInt(0),
+                args[Compact].AsBool(false),
+                args[Chromaguide].AsBool(false),
+                args[Lookahead].AsBool(false),
+                args[Recursive].AsBool(false),
+                args[Fmaxr].AsInt(args[Maxr].AsInt(3)),
                 env);
         else
             return new TTempSmooth<true, false>(
@@ -959,6 +2760,17 @@ AVSValue __cdecl Create_TTempSmooth(AVSValue args, void* user_data, IScriptEnvir
                 args[Upnew].AsInt(0),
                 args[Vpnew].AsInt(0),
                 args[Threads].AsInt(1),
+                args[Tile].AsInt(0),
+                args[Batch].AsInt(1),
+                args[Scstep].AsInt(1),
+                args[Scprops].AsInt(0),
+                args[Scfile].AsString(""),
+                args[Scfilemode].AsInt(0),
+                args[Compact].AsBool(false),
+                args[Chromaguide].AsBool(false),
+                args[Lookahead].AsBool(false),
+                args[Recursive].AsBool(false),
+                args[Fmaxr].AsInt(args[Maxr].AsInt(3)),
                 env);
     }
     else
@@ -988,6 +2800,17 @@ AVSValue __cdecl Create_TTempSmooth(AVSValue args, void* user_data, IScriptEnvir
                 args[Upnew].AsInt(0),
                 args[Vpnew].AsInt(0),
                 args[Threads].AsInt(1),
+                args[Tile].AsInt(0),
+                args[Batch].AsInt(1),
+                args[Scstep].AsInt(1),
+                args[Scprops].AsInt(0),
+                args[Scfile].AsString(""),
+                args[Scfilemode].AsInt(0),
+                args[Compact].AsBool(false),
+                args[Chromaguide].AsBool(false),
+                args[Lookahead].AsBool(false),
+                args[Recursive].AsBool(false),
+                args[Fmaxr].AsInt(args[Maxr].AsInt(3)),
                 env);
         else
             return new TTempSmooth<false, false>(
@@ -1014,6 +2837,17 @@ AVSValue __cdecl Create_TTempSmooth(AVSValue args, void* user_data, IScriptEnvir
                 args[Upnew].AsInt(0),
                 args[Vpnew].AsInt(0),
                 args[Threads].AsInt(1),
+                args[Tile].AsInt(0),
+                args[Batch].AsInt(1),
+                args[Scstep].AsInt(1),
+                args[Scprops].AsInt(0),
+                args[Scfile].AsString(""),
+                args[Scfilemode].AsInt(0),
+                args[Compact].AsBool(false),
+                args[Chromaguide].AsBool(false),
+                args[Lookahead].AsBool(false),
+                args[Recursive].AsBool(false),
+                args[Fmaxr].AsInt(args[Maxr].AsInt(3)),
                 env);
     }
 }
@@ -1025,6 +2859,6 @@ const char* __stdcall AvisynthPluginInit3(IScriptEnvironment * env, const AVS_Li
 {
     AVS_linkage = vectors;
 
-    env->AddFunction("vsTTempSmooth", "c[maxr]i[ythresh]i[uthresh]i[vthresh]i[ymdiff]i[umdiff]i[vmdiff]i[strength]i[scthresh]f[fp]b[y]i[u]i[v]i[pfclip]c[opt]i[pmode]i[ythupd]i[uthupd]i[vthupd]i[ypnew]i[upnew]i[vpnew]i[threads]i", Create_TTempSmooth, 0);
+    env->AddFunction("vsTTempSmooth", "c[maxr]i[ythresh]i[uthresh]i[vthresh]i[ymdiff]i[umdiff]i[vmdiff]i[strength]i[scthresh]f[fp]b[y]i[u]i[v]i[pfclip]c[opt]i[pmode]i[ythupd]i[uthupd]i[vthupd]i[ypnew]i[upnew]i[vpnew]i[threads]i[tile]i[batch]i[scstep]i[scprops]i[scfile]s[scfilemode]i[compact]b[chromaguide]b[lookahead]b[recursive]b[fmaxr]i", Create_TTempSmooth, 0);
     return "vsTTempSmooth";
 }
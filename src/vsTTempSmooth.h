@@ -2,11 +2,22 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include <xmmintrin.h>
+
 #include "avisynth.h"
 
 #define MAX_TEMP_RAD 128
+#define MAX_BATCH 16
 
 #define SIMD_AVX512_SPP 64
 #define SIMD_AVX2_SPP 32
@@ -15,10 +26,172 @@
 [[maybe_unused]]
 static AVS_FORCEINLINE unsigned int INTABS(int x) { return (x < 0) ? -x : x; }
 
+// pulls the [x0, x1) part of the next row of every window frame into L2; pfp is the same stream as srcp without pfclip
+template <typename T, int diameter, bool pfclip>
+static AVS_FORCEINLINE void prefetch_next_row(const T* const* srcp, const T* const* pfp, const int* src_stride, const int* pf_stride, const int x0, const int x1) noexcept
+{
+    for (int i{ 0 }; i < diameter; ++i)
+    {
+        const char* s{ reinterpret_cast<const char*>(srcp[i] + src_stride[i]) };
+        const char* p{ reinterpret_cast<const char*>(pfp[i] + pf_stride[i]) };
+
+        for (int x{ x0 * static_cast<int>(sizeof(T)) }; x < x1 * static_cast<int>(sizeof(T)); x += 64)
+        {
+            _mm_prefetch(s + x, _MM_HINT_T1);
+
+            if constexpr (pfclip)
+                _mm_prefetch(p + x, _MM_HINT_T1);
+        }
+    }
+}
+
+// logical processors the process may run on: the affinity mask, limited by the cgroup CPU quota on Linux
+int processor_count() noexcept;
+
+// a counter of the logical processors left to all instances in the process, not a pool: the threads are OpenMP's own;
+// the calling thread of every request is counted first, a region gets at most what is left on top of it,
+// so Prefetch with several instances doesn't oversubscribe, and always runs on the calling thread
+class thread_budget
+{
+    // counted when a filter first needs it, not while the plugin is being loaded
+    static std::atomic<int>& available() noexcept
+    {
+        static std::atomic<int> left{ processor_count() };
+        return left;
+    }
+
+    static inline thread_local bool measuring{ false };
+    static inline thread_local bool calling{ false };
+    int taken;
+    bool shared;
+
+public:
+    explicit thread_budget(const int threads) noexcept : taken{ 0 }, shared{ !measuring }
+    {
+        if (!shared)
+        {
+            taken = std::max(threads - 1, 0);
+            return;
+        }
+
+        int left{ available().load(std::memory_order_relaxed) };
+
+        do
+            taken = std::clamp(threads - 1, 0, std::max(left, 0));
+        while (!available().compare_exchange_weak(left, left - taken, std::memory_order_relaxed));
+    }
+
+    ~thread_budget()
+    {
+        if (shared)
+            available().fetch_add(taken, std::memory_order_relaxed);
+    }
+
+    thread_budget(const thread_budget&) = delete;
+    thread_budget& operator=(const thread_budget&) = delete;
+
+    int threads() const noexcept { return taken + 1; }
+
+    // while alive, the thread is counted as a request's calling thread; a request of a nested instance isn't counted twice
+    class caller
+    {
+        bool counted;
+
+    public:
+        caller() noexcept : counted{ !calling }
+        {
+            if (counted)
+            {
+                calling = true;
+                available().fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        ~caller()
+        {
+            if (counted)
+            {
+                available().fetch_add(1, std::memory_order_relaxed);
+                calling = false;
+            }
+        }
+
+        caller(const caller&) = delete;
+        caller& operator=(const caller&) = delete;
+    };
+
+    // while alive, the regions of the calling thread get the threads they ask for and leave the shared budget alone,
+    // so a timing doesn't depend on what other instances hold at that moment
+    class measurement
+    {
+    public:
+        measurement() noexcept { measuring = true; }
+        ~measurement() { measuring = false; }
+
+        measurement(const measurement&) = delete;
+        measurement& operator=(const measurement&) = delete;
+    };
+};
+
+void* huge_page_alloc(const size_t size);
+void huge_page_free(void* p) noexcept;
+
+// backs large buffers with 2 MB pages where the OS allows it; elements are default-initialized
+// so the pages aren't touched before the threads that use them write them
+template <typename T>
+struct huge_page_allocator
+{
+    typedef T value_type;
+
+    huge_page_allocator() noexcept = default;
+    template <typename U>
+    huge_page_allocator(const huge_page_allocator<U>&) noexcept {}
+
+    T* allocate(const size_t n) { return static_cast<T*>(huge_page_alloc(n * sizeof(T))); }
+    void deallocate(T* p, const size_t) noexcept { huge_page_free(p); }
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args)
+    {
+        if constexpr (sizeof...(Args) == 0)
+            ::new (static_cast<void*>(p)) U;
+        else
+            ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    bool operator==(const huge_page_allocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const huge_page_allocator<U>&) const noexcept { return false; }
+};
+
+// kernel temporaries of the calling thread: 64-byte aligned, grown to the largest size requested and reused by later frames
+inline void* thread_scratch(const size_t size)
+{
+    struct aligned_delete
+    {
+        void operator()(uint8_t* p) const noexcept { ::operator delete(p, std::align_val_t{ 64 }); }
+    };
+
+    thread_local std::unique_ptr<uint8_t, aligned_delete> buffer;
+    thread_local size_t capacity{ 0 };
+
+    if (size > capacity)
+    {
+        buffer.reset(static_cast<uint8_t*>(::operator new(size, std::align_val_t{ 64 })));
+        capacity = size;
+    }
+
+    return buffer.get();
+}
+
 template<bool pfclip, bool fp>
 class TTempSmooth : public GenericVideoFilter
 {
+    // kernel radius; the window reaches _bmaxr frames back and _fmaxr frames ahead of the current frame
     int _maxr;
+    int _bmaxr;
+    int _fmaxr;
     float _scthresh;
     int _diameter;
     int _thresh[3];
@@ -33,45 +206,194 @@ class TTempSmooth : public GenericVideoFilter
     int _opt;
 
     int _pmode;
-    std::array<std::vector<uint8_t>, 3> pIIRMem;
+    std::array<std::vector<uint8_t, huge_page_allocator<uint8_t>>, 3> pIIRMem;
     int _thUPD[3];
-    std::array<std::vector<int>, 3> pMinSumMem;
-    std::array<std::vector<float>, 3> pMinSumMemF;
+    std::array<std::vector<int, huge_page_allocator<int>>, 3> pMinSumMem;
+    std::array<std::vector<float, huge_page_allocator<float>>, 3> pMinSumMemF;
+    // IIR memory is initialized by the first frame, by the threads that keep processing its rows (first touch)
+    bool _iir_touched[3];
+    // recursive pmode=0: weight of the history per frame and the frame whose output the state in pIIRMem holds
+    bool _recursive;
+    float _decay;
+    int _recursive_n;
     int _pnew[3];
     int _threads;
+    int _tile;
+    int _batch;
+    int _scstep;
+    int _scprops;
+    int _l2;
+    bool _chromaguide;
+    // chromaguide records of a batch, written and read within one request (the instance isn't shared between threads then)
+    std::vector<uint32_t, huge_page_allocator<uint32_t>> _guides;
+    // TTempSmoothHugePages: 1 if all buffers of 2 MB and more got huge pages, 0 if one didn't, -1 without such buffers
+    int _huge_pages;
 
+    // outputs computed ahead by the last batch, handed out by the following GetFrame calls
+    std::vector<PVideoFrame> _ahead;
+    int _ahead_first;
+    int _last_n;
 
-    template<typename T, bool useDiff>
-    void filterI(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-    template<bool useDiff>
-    void filterF(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+    // source frames of the last windows, direct-mapped by frame number; sequential requests fetch only the new ones
+    std::vector<std::pair<int, PVideoFrame>> _window;
+    // pfclip frames of the same slots
+    std::vector<PVideoFrame> _window_pf;
+    std::mutex _window_mutex;
+    // MT_NICE_FILTER: requests in progress; once two overlap, the threads would evict each other's frames, so the table isn't used from then on
+    std::atomic<int> _requests;
+    std::atomic<bool> _window_bypass;
 
-    template<typename T, bool useDiff>
-    void filterI_sse2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-    template<bool useDiff>
-    void filterF_sse2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+    // scene-change metric of frames f and f + 1, direct-mapped by f (exact up to the scthresh decision)
+    std::vector<std::pair<int, float>> _sc_cache;
+    // scstep x scstep block sums of the luma of frame f, direct-mapped by f
+    std::vector<std::pair<int, std::shared_ptr<const std::vector<float>>>> _sc_thumbs;
+    std::mutex _sc_mutex;
+    // memory-mapped stats file: metric of frames f and f + 1 at [f], NaN if not computed
+    float* _scfile;
+    void* _scfile_view;
+    size_t _scfile_size;
+    int _scfilemode;
+    std::once_flag _scfile_checked;
+    // pmode=1 window frames kept at 8 bits; the full-precision center is requested again for the output
+    bool _compact;
+    VideoInfo _vi_compact;
+    int _compact_shift;
+    // synthetic full-precision center used instead of the clip's while tune() runs
+    PVideoFrame _tune_center;
+    // bit depth of the frames compared for scene changes
+    int _sc_bits;
+    // the new frames of the next sequential window are fetched with the current window, their scene-change metrics are computed while it is filtered
+    bool _lookahead;
+    std::future<void> _lookahead_task;
+    // clip and pfclip frames _lookahead_first.. for the window once the request is done
+    std::vector<std::pair<PVideoFrame, PVideoFrame>> _lookahead_frames;
+    int _lookahead_first;
+
+
+    typedef void(TTempSmooth::* filter_t)(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide);
+    // distinct frames of the window: slot[i] is the first of mult[i] slots holding the same clamped edge frame; the center slot is never merged
+    struct window_slots
+    {
+        int num;
+        int slot[MAX_TEMP_RAD * 2 + 1];
+        int mult[MAX_TEMP_RAD * 2 + 1];
+    };
+
+    typedef void(TTempSmooth::* filter_mode2_t)(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
 
+    // per-plane pmode=0 kernel, resolved once in the constructor; processes rows [y0, y1)
+    filter_t filter[3];
+    filter_mode2_t filter_mode2;
+
+    // recursive pmode=0 over the previous, current and next frame; the state rows are padded for the AVX2 kernel
+    typedef void(TTempSmooth::* filter_recursive_t)(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+    filter_recursive_t filter_recursive;
+
+    static constexpr size_t recursive_stride(const size_t width) noexcept { return (width + 15) & ~static_cast<size_t>(15); }
+
+    // frame at position i of the span of count outputs from n; positions outside the radii and the clip repeat the nearest frame inside
+    int window_frame(const int n, const int count, const int i) const noexcept
+    {
+        return std::clamp(n - _maxr + i, std::max(n - _bmaxr, 0), std::min(n + count - 1 + _fmaxr, vi.num_frames - 1));
+    }
+
+    // U and V in one pass when both are processed with the same kind of weights; nullptr otherwise
+    typedef void(TTempSmooth::* filter_uv_t)(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int y0, const int y1) noexcept;
+    filter_uv_t filter_uv;
+
+    // chromaguide: the C/AVX2 luma kernels record in guide the accepted frames (bits 0..14) and the largest accepted difference (bits 16..23) of every sample;
+    // the chroma kernels weight the frames the subsampled record accepted by that difference instead of checking their own
+    typedef void(TTempSmooth::* filter_guided_t)(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const uint32_t* guide, const int plane, const int y0, const int y1) noexcept;
+    filter_guided_t filter_guided[3];
+
+    // row stride of the guide records; the SIMD kernels write whole vectors past the width
+    static constexpr size_t guide_stride(const size_t width) noexcept { return (width + 63) & ~static_cast<size_t>(63); }
+    size_t luma_guide_size() const noexcept { return guide_stride(vi.width) * vi.height; }
+    size_t chroma_guide_size() const noexcept { return guide_stride(vi.width >> vi.GetPlaneWidthSubsampling(PLANAR_U)) * (vi.height >> vi.GetPlaneHeightSubsampling(PLANAR_U)); }
+
+    template<typename T, bool useDiff, int maxr>
+    void filterI(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept;
+    template<bool useDiff, int maxr>
+    void filterF(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept;
+
+    template<typename T, bool useDiff, int maxr>
+    void filterI_sse2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept;
+    template<bool useDiff, int maxr>
+    void filterF_sse2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept;
+
+    template<typename T, bool useDiff, int maxr>
+    void filterI_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept;
+    template<bool useDiff, int maxr>
+    void filterF_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept;
+
+    template<typename T, bool useDiff, int maxr>
+    void filterI_avx512(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept;
+    template<bool useDiff, int maxr>
+    void filterF_avx512(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept;
+
+    template<typename T, bool useDiff, int maxr>
+    void filterUV(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int y0, const int y1) noexcept;
+    template<typename T, bool useDiff, int maxr>
+    void filterUV_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int y0, const int y1) noexcept;
+
+    // pmode=0 kernel instantiated for the current _maxr
+    template<typename T, bool useDiff>
+    filter_t get_filter() const noexcept;
     template<typename T, bool useDiff>
-    void filterI_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-    template<bool useDiff>
-    void filterF_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+    filter_t get_filter_sse2() const noexcept;
+    template<typename T, bool useDiff>
+    filter_t get_filter_avx2() const noexcept;
+    template<typename T, bool useDiff>
+    filter_t get_filter_avx512() const noexcept;
+    template<typename T, bool useDiff>
+    filter_t select_filter(const int opt) const noexcept;
+    template<typename T, bool useDiff>
+    filter_uv_t get_filter_uv() const noexcept;
+    template<typename T, bool useDiff>
+    filter_uv_t get_filter_uv_avx2() const noexcept;
+    template<typename T, bool useDiff>
+    filter_guided_t get_filter_guided_avx2() const noexcept;
 
     template<typename T, bool useDiff>
-    void filterI_avx512(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-    template<bool useDiff>
-    void filterF_avx512(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+    void filterC_guided(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const uint32_t* guide, const int plane, const int y0, const int y1) noexcept;
+    template<typename T, bool useDiff, int maxr>
+    void filterI_guided_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const uint32_t* guide, const int plane, const int y0, const int y1) noexcept;
+    template<bool useDiff, int maxr>
+    void filterF_guided_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const uint32_t* guide, const int plane, const int y0, const int y1) noexcept;
 
-    float (*compare)(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
+    // normalized luma SAD; may return early with any value above limit once that is certain
+    float (*compare)(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
+    void (*thumbnail)(PVideoFrame& src, const int step, std::vector<float>& thumb);
 
     template<typename T>
-    void filter_mode2_C(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+    void filter_recursive_C(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+    template<typename T>
+    void filter_recursive_avx2(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+    template<typename T>
+    void filter_mode2_C(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
     template<typename T>
-    void filterI_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+    void filterI_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
 
-    void filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-    void filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+    void filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+    void filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
 
-    void(TTempSmooth::* filter_mode2)(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+    // computes outputs n..n+count-1 band by band; outputs after n are kept in _ahead
+    PVideoFrame process_frames(const int n, const int count, IScriptEnvironment* env);
+    float sc_metric(const int f, PVideoFrame& src, PVideoFrame& src1);
+    // frames with fewer pixels (about 512x512) compare a pair in about the time the threads take to wake, so their pairs are compared serially
+    static constexpr int sc_parallel_pixels{ 1 << 18 };
+    std::shared_ptr<const std::vector<float>> sc_thumb(const int f, PVideoFrame& src);
+    // compares the frames of the clip with the fingerprint of scfile; a file being written is started over on a mismatch
+    void check_scfile(IScriptEnvironment* env);
+    PVideoFrame compact_frame(PVideoFrame& src, IScriptEnvironment* env);
+    // kernels of _opt for the planes to process
+    void select_kernels() noexcept;
+    // times process_frames on synthetic frames to pick opt and/or threads
+    void tune(const bool tune_opt, const bool tune_threads, IScriptEnvironment* env);
+    // frame f of clip and pfclip as held in the window
+    void fetch_frame(const int f, PVideoFrame& frame, PVideoFrame& frame_pf, IScriptEnvironment* env);
+    // fetches the window of n and the new frames of the next one; false without a spare thread
+    bool look_ahead(const int n, const int count, IScriptEnvironment* env);
 
 #ifdef _DEBUG
     //MEL debug stat
@@ -83,19 +405,32 @@ class TTempSmooth : public GenericVideoFilter
 public:
     TTempSmooth(PClip _child, int maxr, int ythresh, int uthresh, int vthresh, int ymdiff, int umdiff, int vmdiff, int strength, float scthresh,
         int y, int u, int v, PClip pfclip_, int opt, int pmode, int ythupd, int uthupd, int vthupd, int ypnew, int upnew, int vpnew, int threads,
-        IScriptEnvironment* env);
+        int tile, int batch, int scstep, int scprops, const char* scfile, int scfilemode, bool compact, bool chromaguide, bool lookahead, bool recursive, int fmaxr, IScriptEnvironment* env);
+    ~TTempSmooth();
     PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override;
     int __stdcall SetCacheHints(int cachehints, int frame_range) override
     {
         //        return cachehints == CACHE_GET_MTMODE ? MT_MULTI_INSTANCE : 0;
         // set to serialized to correct work of IIR mode ?
-        return cachehints == CACHE_GET_MTMODE ? ((_pmode == 1 && (_thUPD[0] > 0 || _thUPD[1] > 0 || _thUPD[2] > 0)) ? MT_SERIALIZED : MT_MULTI_INSTANCE) : 0;
+        if (cachehints == CACHE_GET_MTMODE)
+        {
+            if ((_pmode == 1 && (_thUPD[0] > 0 || _thUPD[1] > 0 || _thUPD[2] > 0)) || _recursive)
+                return MT_SERIALIZED;
+
+            // pmode=0 shares one instance between all threads unless batch or lookahead keeps state for the next request or chromaguide needs its buffer
+            return (_pmode == 0 && _batch == 1 && !_lookahead && !_chromaguide) ? MT_NICE_FILTER : MT_MULTI_INSTANCE;
+        }
+        // temporal window moving with n
+        if (cachehints == CACHE_GETCHILD_ACCESS_COST)
+            return CACHE_ACCESS_SEQ1;
+
+        return 0;
     }
 };
 
 template <typename T>
-float ComparePlane_sse2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
+float ComparePlane_sse2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
 template <typename T>
-float ComparePlane_avx2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
+float ComparePlane_avx2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
 template <typename T>
-float ComparePlane_avx512(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
+float ComparePlane_avx512(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
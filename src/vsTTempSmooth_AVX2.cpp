@@ -10,531 +10,1257 @@ AVS_FORCEINLINE static Vec8i load(const void* p)
         return Vec8i().load_8us(p);
 }
 
+// integer samples widened to Vec8i, float samples as they are
+template <typename T>
+AVS_FORCEINLINE static auto load_vec(const T* p)
+{
+    if constexpr (std::is_same_v<T, float>)
+        return Vec8f().load(p);
+    else
+        return load<T>(p);
+}
+
+AVS_FORCEINLINE static Vec8f as_float(const Vec8i& v) { return to_float(v); }
+AVS_FORCEINLINE static Vec8f as_float(const Vec8f& v) { return v; }
+
+template <typename V, typename T>
+AVS_FORCEINLINE static void store(const V& v, T* p, const bool nt)
+{
+    if (nt)
+        v.store_nt(p);
+    else
+        v.store(p);
+}
+
 template <bool pfclip, bool fp>
-template <typename T, bool useDiff>
-void TTempSmooth<pfclip, fp>::filterI_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept
+template <typename T, bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterI_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept
 {
-    int src_stride[15]{};
-    int pf_stride[15]{};
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
+    int pf_stride[diameter]{};
     const size_t stride{ dst->GetPitch(plane) / sizeof(T) };
     const size_t width{ dst->GetRowSize(plane) / sizeof(T) };
-    const int height{ dst->GetHeight(plane) };
-    const T* srcp[15]{}, * pfp[15]{};
-    for (int i{ 0 }; i < _diameter; ++i)
+    const int height{ y1 - y0 };
+    const T* srcp[diameter]{}, * pfp[diameter]{};
+    for (int i{ 0 }; i < diameter; ++i)
     {
         src_stride[i] = src[i]->GetPitch(plane) / sizeof(T);
         pf_stride[i] = pf[i]->GetPitch(plane) / sizeof(T);
-        srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane));
-        pfp[i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(plane));
+        srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane)) + y0 * src_stride[i];
+        pfp[i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(plane)) + y0 * pf_stride[i];
     }
 
-    T* __restrict dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) };
+    T* __restrict dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) + y0 * stride };
+
+    if (guide)
+        guide += y0 * guide_stride(width);
 
     const int l{ plane >> 1 };
+    const int shift{ (std::is_same_v<T, uint8_t>) ? 0 : _shift };
     const float* const weightSaved{ _weight[l].data() };
-    const Vec8i thresh{ _thresh[l] << _shift };
+    const Vec8i thresh{ _thresh[l] << shift };
+    const int tile{ (_tile > 0) ? _tile : static_cast<int>(width) };
 
     if constexpr (std::is_same_v<T, uint8_t>)
     {
-        for (int y{ 0 }; y < height; ++y)
+        for (int x0{ 0 }; x0 < static_cast<int>(width); x0 += tile)
         {
-            for (int x{ 0 }; x < width; x += 32)
-            {
-                const auto& c01{ load<T>(&pfp[_maxr][x]) };
-                const auto& srcp_v01{ load<T>(&srcp[_maxr][x]) };
-
-                const auto& c02{ load<T>(&pfp[_maxr][x + 8]) };
-                const auto& srcp_v02{ load<T>(&srcp[_maxr][x + 8]) };
+            const int x1{ std::min(x0 + tile, static_cast<int>(width)) };
 
-                const auto& c03{ load<T>(&pfp[_maxr][x + 16]) };
-                const auto& srcp_v03{ load<T>(&srcp[_maxr][x + 16]) };
+            for (int y{ 0 }; y < height; ++y)
+            {
+                if (_tile > 0)
+                    prefetch_next_row<T, diameter, pfclip>(srcp, pfp, src_stride, pf_stride, x0, x1);
 
-                const auto& c04{ load<T>(&pfp[_maxr][x + 24]) };
-                const auto& srcp_v04{ load<T>(&srcp[_maxr][x + 24]) };
+                for (int x{ x0 }; x < x1; x += 32)
+                {
+                    const auto& c01{ load<T>(&pfp[maxr][x]) };
+                    const auto& srcp_v01{ (pfclip) ? load<T>(&srcp[maxr][x]) : c01 };
 
-                Vec8f weights01{ _cw };
-                auto sum01{ to_float(srcp_v01) * weights01 };
+                    const auto& c02{ load<T>(&pfp[maxr][x + 8]) };
+                    const auto& srcp_v02{ (pfclip) ? load<T>(&srcp[maxr][x + 8]) : c02 };
 
-                Vec8f weights02{ _cw };
-                auto sum02{ to_float(srcp_v02) * weights02 };
+                    const auto& c03{ load<T>(&pfp[maxr][x + 16]) };
+                    const auto& srcp_v03{ (pfclip) ? load<T>(&srcp[maxr][x + 16]) : c03 };
 
-                Vec8f weights03{ _cw };
-                auto sum03{ to_float(srcp_v03) * weights03 };
+                    const auto& c04{ load<T>(&pfp[maxr][x + 24]) };
+                    const auto& srcp_v04{ (pfclip) ? load<T>(&srcp[maxr][x + 24]) : c04 };
 
-                Vec8f weights04{ _cw };
-                auto sum04{ to_float(srcp_v04) * weights04 };
+                    Vec8f weights01{ _cw };
+                    auto sum01{ to_float(srcp_v01) * weights01 };
+                    Vec8i accepted01{ 0 };
+                    Vec8i bucket01{ 0 };
 
-                int frameIndex{ _maxr - 1 };
+                    Vec8f weights02{ _cw };
+                    auto sum02{ to_float(srcp_v02) * weights02 };
+                    Vec8i accepted02{ 0 };
+                    Vec8i bucket02{ 0 };
 
-                if (frameIndex > fromFrame)
-                {
-                    auto t1_01{ load<T>(&pfp[frameIndex][x]) };
-                    auto diff01{ abs(c01 - t1_01) };
-                    const auto check_v01{ diff01 < thresh };
+                    Vec8f weights03{ _cw };
+                    auto sum03{ to_float(srcp_v03) * weights03 };
+                    Vec8i accepted03{ 0 };
+                    Vec8i bucket03{ 0 };
 
-                    auto t1_02{ load<T>(&pfp[frameIndex][x + 8]) };
-                    auto diff02{ abs(c02 - t1_02) };
-                    const auto check_v02{ diff02 < thresh };
+                    Vec8f weights04{ _cw };
+                    auto sum04{ to_float(srcp_v04) * weights04 };
+                    Vec8i accepted04{ 0 };
+                    Vec8i bucket04{ 0 };
 
-                    auto t1_03{ load<T>(&pfp[frameIndex][x + 16]) };
-                    auto diff03{ abs(c03 - t1_03) };
-                    const auto check_v03{ diff03 < thresh };
+                    int frameIndex{ maxr - 1 };
 
-                    auto t1_04{ load<T>(&pfp[frameIndex][x + 24]) };
-                    auto diff04{ abs(c04 - t1_04) };
-                    const auto check_v04{ diff04 < thresh };
+                    if (frameIndex > fromFrame)
+                    {
+                        auto t1_01{ load<T>(&pfp[frameIndex][x]) };
+                        auto diff01{ abs(c01 - t1_01) };
+                        auto check_v01{ diff01 < thresh };
+
+                        auto t1_02{ load<T>(&pfp[frameIndex][x + 8]) };
+                        auto diff02{ abs(c02 - t1_02) };
+                        auto check_v02{ diff02 < thresh };
+
+                        auto t1_03{ load<T>(&pfp[frameIndex][x + 16]) };
+                        auto diff03{ abs(c03 - t1_03) };
+                        auto check_v03{ diff03 < thresh };
+
+                        auto t1_04{ load<T>(&pfp[frameIndex][x + 24]) };
+                        auto diff04{ abs(c04 - t1_04) };
+                        auto check_v04{ diff04 < thresh };
+
+                        auto weight01{ (useDiff) ? lookup<256 * maxr>(diff01 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight02{ (useDiff) ? lookup<256 * maxr>(diff02 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight03{ (useDiff) ? lookup<256 * maxr>(diff03 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight04{ (useDiff) ? lookup<256 * maxr>(diff04 >> shift, weightSaved) : weightSaved[frameIndex] };
+
+                        weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
+                        accepted01 = if_add(check_v01, accepted01, Vec8i(1 << frameIndex));
+                        bucket01 = select(check_v01, max(bucket01, diff01 >> shift), bucket01);
+                        weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
+                        accepted02 = if_add(check_v02, accepted02, Vec8i(1 << frameIndex));
+                        bucket02 = select(check_v02, max(bucket02, diff02 >> shift), bucket02);
+                        weights03 = select(Vec8fb(check_v03), weights03 + weight03, weights03);
+                        accepted03 = if_add(check_v03, accepted03, Vec8i(1 << frameIndex));
+                        bucket03 = select(check_v03, max(bucket03, diff03 >> shift), bucket03);
+                        weights04 = select(Vec8fb(check_v04), weights04 + weight04, weights04);
+                        accepted04 = if_add(check_v04, accepted04, Vec8i(1 << frameIndex));
+                        bucket04 = select(check_v04, max(bucket04, diff04 >> shift), bucket04);
+
+                        sum01 = select(Vec8fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                        sum02 = select(Vec8fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_02), weight02, sum02), sum02);
+                        sum03 = select(Vec8fb(check_v03), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 16]) : t1_03), weight03, sum03), sum03);
+                        sum04 = select(Vec8fb(check_v04), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 24]) : t1_04), weight04, sum04), sum04);
 
-                    auto weight01{ (useDiff) ? lookup<1792>(diff01 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight02{ (useDiff) ? lookup<1792>(diff02 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight03{ (useDiff) ? lookup<1792>(diff03 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight04{ (useDiff) ? lookup<1792>(diff04 >> _shift, weightSaved) : weightSaved[frameIndex] };
+                        --frameIndex;
+                        int v{ 256 };
+
+                        if constexpr (maxr > 1)
+                        {
+                            while (frameIndex > fromFrame)
+                            {
+                                const auto t2_01{ t1_01 };
+                                t1_01 = load<T>(&pfp[frameIndex][x]);
+                                diff01 = abs(c01 - t1_01);
+                                check_v01 = check_v01 && diff01 < thresh && abs(t1_01 - t2_01) < thresh;
+
+                                const auto t2_02{ t1_02 };
+                                t1_02 = load<T>(&pfp[frameIndex][x + 8]);
+                                diff02 = abs(c02 - t1_02);
+                                check_v02 = check_v02 && diff02 < thresh && abs(t1_02 - t2_02) < thresh;
+
+                                const auto t2_03{ t1_03 };
+                                t1_03 = load<T>(&pfp[frameIndex][x + 16]);
+                                diff03 = abs(c03 - t1_03);
+                                check_v03 = check_v03 && diff03 < thresh && abs(t1_03 - t2_03) < thresh;
+
+                                const auto t2_04{ t1_04 };
+                                t1_04 = load<T>(&pfp[frameIndex][x + 24]);
+                                diff04 = abs(c04 - t1_04);
+                                check_v04 = check_v04 && diff04 < thresh && abs(t1_04 - t2_04) < thresh;
+
+                                if (!horizontal_or(check_v01 | check_v02 | check_v03 | check_v04))
+                                    break;
+
+                                weight01 = (useDiff) ? lookup<256 * maxr>((diff01 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight02 = (useDiff) ? lookup<256 * maxr>((diff02 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight03 = (useDiff) ? lookup<256 * maxr>((diff03 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight04 = (useDiff) ? lookup<256 * maxr>((diff04 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+
+                                weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
+                                accepted01 = if_add(check_v01, accepted01, Vec8i(1 << frameIndex));
+                                bucket01 = select(check_v01, max(bucket01, diff01 >> shift), bucket01);
+                                weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
+                                accepted02 = if_add(check_v02, accepted02, Vec8i(1 << frameIndex));
+                                bucket02 = select(check_v02, max(bucket02, diff02 >> shift), bucket02);
+                                weights03 = select(Vec8fb(check_v03), weights03 + weight03, weights03);
+                                accepted03 = if_add(check_v03, accepted03, Vec8i(1 << frameIndex));
+                                bucket03 = select(check_v03, max(bucket03, diff03 >> shift), bucket03);
+                                weights04 = select(Vec8fb(check_v04), weights04 + weight04, weights04);
+                                accepted04 = if_add(check_v04, accepted04, Vec8i(1 << frameIndex));
+                                bucket04 = select(check_v04, max(bucket04, diff04 >> shift), bucket04);
+
+                                sum01 = select(Vec8fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                                sum02 = select(Vec8fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_02), weight02, sum02), sum02);
+                                sum03 = select(Vec8fb(check_v03), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 16]) : t1_03), weight03, sum03), sum03);
+                                sum04 = select(Vec8fb(check_v04), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 24]) : t1_04), weight04, sum04), sum04);
+
+                                --frameIndex;
+                                v += 256;
+                            }
+                        }
+                    }
 
-                    weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
-                    weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
-                    weights03 = select(Vec8fb(check_v03), weights03 + weight03, weights03);
-                    weights04 = select(Vec8fb(check_v04), weights04 + weight04, weights04);
+                    frameIndex = maxr + 1;
 
-                    sum01 = select(Vec8fb(check_v01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                    sum02 = select(Vec8fb(check_v02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight02, sum02), sum02);
-                    sum03 = select(Vec8fb(check_v03), mul_add(to_float(load<T>(&srcp[frameIndex][x + 16])), weight03, sum03), sum03);
-                    sum04 = select(Vec8fb(check_v04), mul_add(to_float(load<T>(&srcp[frameIndex][x + 24])), weight04, sum04), sum04);
+                    if (frameIndex < toFrame)
+                    {
+                        auto t1_01{ load<T>(&pfp[frameIndex][x]) };
+                        auto diff01{ abs(c01 - t1_01) };
+                        auto check_v01{ diff01 < thresh };
+
+                        auto t1_02{ load<T>(&pfp[frameIndex][x + 8]) };
+                        auto diff02{ abs(c02 - t1_02) };
+                        auto check_v02{ diff02 < thresh };
+
+                        auto t1_03{ load<T>(&pfp[frameIndex][x + 16]) };
+                        auto diff03{ abs(c03 - t1_03) };
+                        auto check_v03{ diff03 < thresh };
+
+                        auto t1_04{ load<T>(&pfp[frameIndex][x + 24]) };
+                        auto diff04{ abs(c04 - t1_04) };
+                        auto check_v04{ diff04 < thresh };
+
+                        auto weight01{ (useDiff) ? lookup<256 * maxr>(diff01 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight02{ (useDiff) ? lookup<256 * maxr>(diff02 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight03{ (useDiff) ? lookup<256 * maxr>(diff03 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight04{ (useDiff) ? lookup<256 * maxr>(diff04 >> shift, weightSaved) : weightSaved[frameIndex] };
+
+                        weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
+                        accepted01 = if_add(check_v01, accepted01, Vec8i(1 << frameIndex));
+                        bucket01 = select(check_v01, max(bucket01, diff01 >> shift), bucket01);
+                        weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
+                        accepted02 = if_add(check_v02, accepted02, Vec8i(1 << frameIndex));
+                        bucket02 = select(check_v02, max(bucket02, diff02 >> shift), bucket02);
+                        weights03 = select(Vec8fb(check_v03), weights03 + weight03, weights03);
+                        accepted03 = if_add(check_v03, accepted03, Vec8i(1 << frameIndex));
+                        bucket03 = select(check_v03, max(bucket03, diff03 >> shift), bucket03);
+                        weights04 = select(Vec8fb(check_v04), weights04 + weight04, weights04);
+                        accepted04 = if_add(check_v04, accepted04, Vec8i(1 << frameIndex));
+                        bucket04 = select(check_v04, max(bucket04, diff04 >> shift), bucket04);
+
+                        sum01 = select(Vec8fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                        sum02 = select(Vec8fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_02), weight02, sum02), sum02);
+                        sum03 = select(Vec8fb(check_v03), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 16]) : t1_03), weight03, sum03), sum03);
+                        sum04 = select(Vec8fb(check_v04), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 24]) : t1_04), weight04, sum04), sum04);
 
-                    --frameIndex;
-                    int v{ 256 };
+                        ++frameIndex;
+                        int v{ 256 };
+
+                        if constexpr (maxr > 1)
+                        {
+                            while (frameIndex < toFrame)
+                            {
+                                const auto t2_01{ t1_01 };
+                                t1_01 = load<T>(&pfp[frameIndex][x]);
+                                diff01 = abs(c01 - t1_01);
+                                check_v01 = check_v01 && diff01 < thresh && abs(t1_01 - t2_01) < thresh;
+
+                                const auto t2_02{ t1_02 };
+                                t1_02 = load<T>(&pfp[frameIndex][x + 8]);
+                                diff02 = abs(c02 - t1_02);
+                                check_v02 = check_v02 && diff02 < thresh && abs(t1_02 - t2_02) < thresh;
+
+                                const auto t2_03{ t1_03 };
+                                t1_03 = load<T>(&pfp[frameIndex][x + 16]);
+                                diff03 = abs(c03 - t1_03);
+                                check_v03 = check_v03 && diff03 < thresh && abs(t1_03 - t2_03) < thresh;
+
+                                const auto t2_04{ t1_04 };
+                                t1_04 = load<T>(&pfp[frameIndex][x + 24]);
+                                diff04 = abs(c04 - t1_04);
+                                check_v04 = check_v04 && diff04 < thresh && abs(t1_04 - t2_04) < thresh;
+
+                                if (!horizontal_or(check_v01 | check_v02 | check_v03 | check_v04))
+                                    break;
+
+                                weight01 = (useDiff) ? lookup<256 * maxr>((diff01 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight02 = (useDiff) ? lookup<256 * maxr>((diff02 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight03 = (useDiff) ? lookup<256 * maxr>((diff03 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight04 = (useDiff) ? lookup<256 * maxr>((diff04 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+
+                                weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
+                                accepted01 = if_add(check_v01, accepted01, Vec8i(1 << frameIndex));
+                                bucket01 = select(check_v01, max(bucket01, diff01 >> shift), bucket01);
+                                weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
+                                accepted02 = if_add(check_v02, accepted02, Vec8i(1 << frameIndex));
+                                bucket02 = select(check_v02, max(bucket02, diff02 >> shift), bucket02);
+                                weights03 = select(Vec8fb(check_v03), weights03 + weight03, weights03);
+                                accepted03 = if_add(check_v03, accepted03, Vec8i(1 << frameIndex));
+                                bucket03 = select(check_v03, max(bucket03, diff03 >> shift), bucket03);
+                                weights04 = select(Vec8fb(check_v04), weights04 + weight04, weights04);
+                                accepted04 = if_add(check_v04, accepted04, Vec8i(1 << frameIndex));
+                                bucket04 = select(check_v04, max(bucket04, diff04 >> shift), bucket04);
+
+                                sum01 = select(Vec8fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                                sum02 = select(Vec8fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_02), weight02, sum02), sum02);
+                                sum03 = select(Vec8fb(check_v03), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 16]) : t1_03), weight03, sum03), sum03);
+                                sum04 = select(Vec8fb(check_v04), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 24]) : t1_04), weight04, sum04), sum04);
+
+                                ++frameIndex;
+                                v += 256;
+                            }
+                        }
+                    }
 
-                    while (frameIndex > fromFrame)
+                    if constexpr (fp)
                     {
-                        const auto& t2_01{ t1_01 };
-                        t1_01 = load<T>(&pfp[frameIndex][x]);
-                        diff01 = abs(c01 - t1_01);
-                        const auto check_v1_01{ diff01 < thresh&& abs(t1_01 - t2_01) < thresh };
-
-                        const auto& t2_02{ t1_02 };
-                        t1_02 = load<T>(&pfp[frameIndex][x + 8]);
-                        diff02 = abs(c02 - t1_02);
-                        const auto check_v1_02{ diff02 < thresh&& abs(t1_02 - t2_02) < thresh };
-
-                        const auto& t2_03{ t1_03 };
-                        t1_03 = load<T>(&pfp[frameIndex][x + 16]);
-                        diff03 = abs(c03 - t1_03);
-                        const auto check_v1_03{ diff03 < thresh&& abs(t1_03 - t2_03) < thresh };
-
-                        const auto& t2_04{ t1_04 };
-                        t1_04 = load<T>(&pfp[frameIndex][x + 24]);
-                        diff04 = abs(c04 - t1_04);
-                        const auto check_v1_04{ diff04 < thresh&& abs(t1_04 - t2_04) < thresh };
-
-                        weight01 = (useDiff) ? lookup<1792>((diff01 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight02 = (useDiff) ? lookup<1792>((diff02 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight03 = (useDiff) ? lookup<1792>((diff03 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight04 = (useDiff) ? lookup<1792>((diff04 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-
-                        weights01 = select(Vec8fb(check_v1_01), weights01 + weight01, weights01);
-                        weights02 = select(Vec8fb(check_v1_02), weights02 + weight02, weights02);
-                        weights03 = select(Vec8fb(check_v1_03), weights03 + weight03, weights03);
-                        weights04 = select(Vec8fb(check_v1_04), weights04 + weight04, weights04);
-
-                        sum01 = select(Vec8fb(check_v1_01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                        sum02 = select(Vec8fb(check_v1_02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight02, sum02), sum02);
-                        sum03 = select(Vec8fb(check_v1_03), mul_add(to_float(load<T>(&srcp[frameIndex][x + 16])), weight03, sum03), sum03);
-                        sum04 = select(Vec8fb(check_v1_04), mul_add(to_float(load<T>(&srcp[frameIndex][x + 24])), weight04, sum04), sum04);
+                        compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x]) : c01), (1.0f - weights01), sum01 + 0.5f)), zero_si256()), zero_si256()).get_low().storel(dstp + x);
+                        compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x + 8]) : c02), (1.0f - weights02), sum02 + 0.5f)), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 8));
+                        compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x + 16]) : c03), (1.0f - weights03), sum03 + 0.5f)), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 16));
+                        compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x + 24]) : c04), (1.0f - weights04), sum04 + 0.5f)), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 24));
+                    }
+                    else
+                    {
+                        compress_saturated_s2u(compress_saturated(truncatei(sum01 / weights01 + 0.5f), zero_si256()), zero_si256()).get_low().storel(dstp + x);
+                        compress_saturated_s2u(compress_saturated(truncatei(sum02 / weights02 + 0.5f), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 8));
+                        compress_saturated_s2u(compress_saturated(truncatei(sum03 / weights03 + 0.5f), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 16));
+                        compress_saturated_s2u(compress_saturated(truncatei(sum04 / weights04 + 0.5f), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 24));
+                    }
 
-                        --frameIndex;
-                        v += 256;
+                    if (guide)
+                    {
+                        (accepted01 | (bucket01 << 16)).store(guide + x);
+                        (accepted02 | (bucket02 << 16)).store(guide + (x + 8));
+                        (accepted03 | (bucket03 << 16)).store(guide + (x + 16));
+                        (accepted04 | (bucket04 << 16)).store(guide + (x + 24));
                     }
                 }
 
-                frameIndex = _maxr + 1;
+                for (int i{ 0 }; i < diameter; ++i)
+                {
+                    srcp[i] += src_stride[i];
+                    pfp[i] += pf_stride[i];
+                }
 
-                if (frameIndex < toFrame)
+                dstp += stride;
+
+                if (guide)
+                    guide += guide_stride(width);
+            }
+
+            for (int i{ 0 }; i < diameter; ++i)
+            {
+                srcp[i] -= src_stride[i] * height;
+                pfp[i] -= pf_stride[i] * height;
+            }
+
+            dstp -= stride * height;
+
+            if (guide)
+                guide -= guide_stride(width) * height;
+        }
+    }
+    else
+    {
+        const bool nt{ _tile > 0 && !(reinterpret_cast<uintptr_t>(dstp) & 63) && !((stride * sizeof(T)) & 63) };
+
+        for (int x0{ 0 }; x0 < static_cast<int>(width); x0 += tile)
+        {
+            const int x1{ std::min(x0 + tile, static_cast<int>(width)) };
+
+            for (int y{ 0 }; y < height; ++y)
+            {
+                if (_tile > 0)
+                    prefetch_next_row<T, diameter, pfclip>(srcp, pfp, src_stride, pf_stride, x0, x1);
+
+                for (int x{ x0 }; x < x1; x += 16)
                 {
-                    auto t1_01{ load<T>(&pfp[frameIndex][x]) };
-                    auto diff01{ abs(c01 - t1_01) };
-                    const auto check_v01{ diff01 < thresh };
+                    const auto& c01{ load<T>(&pfp[maxr][x]) };
+                    const auto& srcp_v01{ (pfclip) ? load<T>(&srcp[maxr][x]) : c01 };
 
-                    auto t1_02{ load<T>(&pfp[frameIndex][x + 8]) };
-                    auto diff02{ abs(c02 - t1_02) };
-                    const auto check_v02{ diff02 < thresh };
+                    const auto& c02{ load<T>(&pfp[maxr][x + 8]) };
+                    const auto& srcp_v02{ (pfclip) ? load<T>(&srcp[maxr][x + 8]) : c02 };
 
-                    auto t1_03{ load<T>(&pfp[frameIndex][x + 16]) };
-                    auto diff03{ abs(c03 - t1_03) };
-                    const auto check_v03{ diff03 < thresh };
+                    Vec8f weights01{ _cw };
+                    auto sum01{ to_float(srcp_v01) * weights01 };
+                    Vec8i accepted01{ 0 };
+                    Vec8i bucket01{ 0 };
 
-                    auto t1_04{ load<T>(&pfp[frameIndex][x + 24]) };
-                    auto diff04{ abs(c04 - t1_04) };
-                    const auto check_v04{ diff04 < thresh };
+                    Vec8f weights02{ _cw };
+                    auto sum02{ to_float(srcp_v02) * weights02 };
+                    Vec8i accepted02{ 0 };
+                    Vec8i bucket02{ 0 };
 
-                    auto weight01{ (useDiff) ? lookup<1792>(diff01 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight02{ (useDiff) ? lookup<1792>(diff02 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight03{ (useDiff) ? lookup<1792>(diff03 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight04{ (useDiff) ? lookup<1792>(diff04 >> _shift, weightSaved) : weightSaved[frameIndex] };
+                    int frameIndex{ maxr - 1 };
 
-                    weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
-                    weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
-                    weights03 = select(Vec8fb(check_v03), weights03 + weight03, weights03);
-                    weights04 = select(Vec8fb(check_v04), weights04 + weight04, weights04);
+                    if (frameIndex > fromFrame)
+                    {
+                        auto t1_01{ load<T>(&pfp[frameIndex][x]) };
+                        auto diff01{ abs(c01 - t1_01) };
+                        auto check_v01{ diff01 < thresh };
 
-                    sum01 = select(Vec8fb(check_v01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                    sum02 = select(Vec8fb(check_v02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight02, sum02), sum02);
-                    sum03 = select(Vec8fb(check_v03), mul_add(to_float(load<T>(&srcp[frameIndex][x + 16])), weight03, sum03), sum03);
-                    sum04 = select(Vec8fb(check_v04), mul_add(to_float(load<T>(&srcp[frameIndex][x + 24])), weight04, sum04), sum04);
+                        auto t1_02{ load<T>(&pfp[frameIndex][x + 8]) };
+                        auto diff02{ abs(c02 - t1_02) };
+                        auto check_v02{ diff02 < thresh };
 
-                    ++frameIndex;
-                    int v{ 256 };
+                        auto weight01{ (useDiff) ? lookup<256 * maxr>(diff01 >> shift, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved) };
+                        auto weight02{ (useDiff) ? lookup<256 * maxr>(diff02 >> shift, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved) };
+
+                        weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
+                        accepted01 = if_add(check_v01, accepted01, Vec8i(1 << frameIndex));
+                        bucket01 = select(check_v01, max(bucket01, diff01 >> shift), bucket01);
+                        weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
+                        accepted02 = if_add(check_v02, accepted02, Vec8i(1 << frameIndex));
+                        bucket02 = select(check_v02, max(bucket02, diff02 >> shift), bucket02);
+
+                        sum01 = select(Vec8fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                        sum02 = select(Vec8fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_02), weight02, sum02), sum02);
+
+                        --frameIndex;
+                        int v{ 256 };
+
+                        if constexpr (maxr > 1)
+                        {
+                            while (frameIndex > fromFrame)
+                            {
+                                const auto t2_01{ t1_01 };
+                                t1_01 = load<T>(&pfp[frameIndex][x]);
+                                diff01 = abs(c01 - t1_01);
+                                check_v01 = check_v01 && diff01 < thresh && abs(t1_01 - t2_01) < thresh;
+
+                                const auto t2_02{ t1_02 };
+                                t1_02 = load<T>(&pfp[frameIndex][x + 8]);
+                                diff02 = abs(c02 - t1_02);
+                                check_v02 = check_v02 && diff02 < thresh && abs(t1_02 - t2_02) < thresh;
+
+                                if (!horizontal_or(check_v01 | check_v02))
+                                    break;
+
+                                weight01 = (useDiff) ? lookup<256 * maxr>((diff01 >> shift) + v, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved);
+                                weight02 = (useDiff) ? lookup<256 * maxr>((diff02 >> shift) + v, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved);
+
+                                weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
+                                accepted01 = if_add(check_v01, accepted01, Vec8i(1 << frameIndex));
+                                bucket01 = select(check_v01, max(bucket01, diff01 >> shift), bucket01);
+                                weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
+                                accepted02 = if_add(check_v02, accepted02, Vec8i(1 << frameIndex));
+                                bucket02 = select(check_v02, max(bucket02, diff02 >> shift), bucket02);
+
+                                sum01 = select(Vec8fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                                sum02 = select(Vec8fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_02), weight02, sum02), sum02);
+
+                                --frameIndex;
+                                v += 256;
+                            }
+                        }
+                    }
+
+                    frameIndex = maxr + 1;
 
-                    while (frameIndex < toFrame)
+                    if (frameIndex < toFrame)
                     {
-                        const auto& t2_01{ t1_01 };
-                        t1_01 = load<T>(&pfp[frameIndex][x]);
-                        diff01 = abs(c01 - t1_01);
-                        const auto check_v1_01{ diff01 < thresh&& abs(t1_01 - t2_01) < thresh };
-
-                        const auto& t2_02{ t1_02 };
-                        t1_02 = load<T>(&pfp[frameIndex][x + 8]);
-                        diff02 = abs(c02 - t1_02);
-                        const auto check_v1_02{ diff02 < thresh&& abs(t1_02 - t2_02) < thresh };
-
-                        const auto& t2_03{ t1_03 };
-                        t1_03 = load<T>(&pfp[frameIndex][x + 16]);
-                        diff03 = abs(c03 - t1_03);
-                        const auto check_v1_03{ diff03 < thresh&& abs(t1_03 - t2_03) < thresh };
-
-                        const auto& t2_04{ t1_04 };
-                        t1_04 = load<T>(&pfp[frameIndex][x + 24]);
-                        diff04 = abs(c04 - t1_04);
-                        const auto check_v1_04{ diff04 < thresh&& abs(t1_04 - t2_04) < thresh };
-
-                        weight01 = (useDiff) ? lookup<1792>((diff01 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight02 = (useDiff) ? lookup<1792>((diff02 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight03 = (useDiff) ? lookup<1792>((diff03 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight04 = (useDiff) ? lookup<1792>((diff04 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-
-                        weights01 = select(Vec8fb(check_v1_01), weights01 + weight01, weights01);
-                        weights02 = select(Vec8fb(check_v1_02), weights02 + weight02, weights02);
-                        weights03 = select(Vec8fb(check_v1_03), weights03 + weight03, weights03);
-                        weights04 = select(Vec8fb(check_v1_04), weights04 + weight04, weights04);
-
-                        sum01 = select(Vec8fb(check_v1_01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                        sum02 = select(Vec8fb(check_v1_02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight02, sum02), sum02);
-                        sum03 = select(Vec8fb(check_v1_03), mul_add(to_float(load<T>(&srcp[frameIndex][x + 16])), weight03, sum03), sum03);
-                        sum04 = select(Vec8fb(check_v1_04), mul_add(to_float(load<T>(&srcp[frameIndex][x + 24])), weight04, sum04), sum04);
+                        auto t1_01{ load<T>(&pfp[frameIndex][x]) };
+                        auto diff01{ abs(c01 - t1_01) };
+                        auto check_v01{ diff01 < thresh };
+
+                        auto t1_02{ load<T>(&pfp[frameIndex][x + 8]) };
+                        auto diff02{ abs(c02 - t1_02) };
+                        auto check_v02{ diff02 < thresh };
+
+                        auto weight01{ (useDiff) ? lookup<256 * maxr>(diff01 >> shift, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved) };
+                        auto weight02{ (useDiff) ? lookup<256 * maxr>(diff02 >> shift, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved) };
+
+                        weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
+                        accepted01 = if_add(check_v01, accepted01, Vec8i(1 << frameIndex));
+                        bucket01 = select(check_v01, max(bucket01, diff01 >> shift), bucket01);
+                        weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
+                        accepted02 = if_add(check_v02, accepted02, Vec8i(1 << frameIndex));
+                        bucket02 = select(check_v02, max(bucket02, diff02 >> shift), bucket02);
+
+                        sum01 = select(Vec8fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                        sum02 = select(Vec8fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_02), weight02, sum02), sum02);
 
                         ++frameIndex;
-                        v += 256;
+                        int v{ 256 };
+
+                        if constexpr (maxr > 1)
+                        {
+                            while (frameIndex < toFrame)
+                            {
+                                const auto t2_01{ t1_01 };
+                                t1_01 = load<T>(&pfp[frameIndex][x]);
+                                diff01 = abs(c01 - t1_01);
+                                check_v01 = check_v01 && diff01 < thresh && abs(t1_01 - t2_01) < thresh;
+
+                                const auto t2_02{ t1_02 };
+                                t1_02 = load<T>(&pfp[frameIndex][x + 8]);
+                                diff02 = abs(c02 - t1_02);
+                                check_v02 = check_v02 && diff02 < thresh && abs(t1_02 - t2_02) < thresh;
+
+                                if (!horizontal_or(check_v01 | check_v02))
+                                    break;
+
+                                weight01 = (useDiff) ? lookup<256 * maxr>((diff01 >> shift) + v, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved);
+                                weight02 = (useDiff) ? lookup<256 * maxr>((diff02 >> shift) + v, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved);
+
+                                weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
+                                accepted01 = if_add(check_v01, accepted01, Vec8i(1 << frameIndex));
+                                bucket01 = select(check_v01, max(bucket01, diff01 >> shift), bucket01);
+                                weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
+                                accepted02 = if_add(check_v02, accepted02, Vec8i(1 << frameIndex));
+                                bucket02 = select(check_v02, max(bucket02, diff02 >> shift), bucket02);
+
+                                sum01 = select(Vec8fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                                sum02 = select(Vec8fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_02), weight02, sum02), sum02);
+
+                                ++frameIndex;
+                                v += 256;
+                            }
+                        }
                     }
-                }
 
-                if constexpr (fp)
-                {
-                    compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x])), (1.0f - weights01), sum01 + 0.5f)), zero_si256()), zero_si256()).get_low().storel(dstp + x);
-                    compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x + 8])), (1.0f - weights02), sum02 + 0.5f)), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 8));
-                    compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x + 16])), (1.0f - weights03), sum03 + 0.5f)), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 16));
-                    compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x + 24])), (1.0f - weights04), sum04 + 0.5f)), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 24));
+                    if constexpr (fp)
+                    {
+                        store(compress_saturated_s2u(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x]) : c01), (1.0f - weights01), sum01 + 0.5f)), zero_si256()).get_low(), dstp + x, nt);
+                        store(compress_saturated_s2u(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x + 8]) : c02), (1.0f - weights02), sum02 + 0.5f)), zero_si256()).get_low(), dstp + (x + 8), nt);
+                    }
+                    else
+                    {
+                        store(compress_saturated_s2u(truncatei(sum01 / weights01 + 0.5f), zero_si256()).get_low(), dstp + x, nt);
+                        store(compress_saturated_s2u(truncatei(sum02 / weights02 + 0.5f), zero_si256()).get_low(), dstp + (x + 8), nt);
+                    }
+
+                    if (guide)
+                    {
+                        (accepted01 | (bucket01 << 16)).store(guide + x);
+                        (accepted02 | (bucket02 << 16)).store(guide + (x + 8));
+                    }
                 }
-                else
+
+                for (int i{ 0 }; i < diameter; ++i)
                 {
-                    compress_saturated_s2u(compress_saturated(truncatei(sum01 / weights01 + 0.5f), zero_si256()), zero_si256()).get_low().storel(dstp + x);
-                    compress_saturated_s2u(compress_saturated(truncatei(sum02 / weights02 + 0.5f), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 8));
-                    compress_saturated_s2u(compress_saturated(truncatei(sum03 / weights03 + 0.5f), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 16));
-                    compress_saturated_s2u(compress_saturated(truncatei(sum04 / weights04 + 0.5f), zero_si256()), zero_si256()).get_low().storel(dstp + (x + 24));
+                    srcp[i] += src_stride[i];
+                    pfp[i] += pf_stride[i];
                 }
+
+                dstp += stride;
+
+                if (guide)
+                    guide += guide_stride(width);
             }
 
-            for (int i{ 0 }; i < _diameter; ++i)
+            for (int i{ 0 }; i < diameter; ++i)
             {
-                srcp[i] += src_stride[i];
-                pfp[i] += pf_stride[i];
+                srcp[i] -= src_stride[i] * height;
+                pfp[i] -= pf_stride[i] * height;
             }
 
-            dstp += stride;
+            dstp -= stride * height;
+
+            if (guide)
+                guide -= guide_stride(width) * height;
         }
+
+        if (nt)
+            _mm_sfence();
     }
-    else
+}
+
+
+template <bool pfclip, bool fp>
+template <bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterF_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept
+{
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
+    int pf_stride[diameter]{};
+    const int stride{ dst->GetPitch(plane) / 4 };
+    const int width{ dst->GetRowSize(plane) / 4 };
+    const int height{ y1 - y0 };
+    const float* srcp[diameter]{}, * pfp[diameter]{};
+    for (int i{ 0 }; i < diameter; ++i)
     {
-        for (int y{ 0 }; y < height; ++y)
-        {
-            for (int x{ 0 }; x < width; x += 16)
-            {
-                const auto& c01{ load<T>(&pfp[_maxr][x]) };
-                const auto& srcp_v01{ load<T>(&srcp[_maxr][x]) };
+        src_stride[i] = src[i]->GetPitch(plane) / 4;
+        pf_stride[i] = pf[i]->GetPitch(plane) / 4;
+        srcp[i] = reinterpret_cast<const float*>(src[i]->GetReadPtr(plane)) + y0 * src_stride[i];
+        pfp[i] = reinterpret_cast<const float*>(pf[i]->GetReadPtr(plane)) + y0 * pf_stride[i];
+    }
+
+    float* __restrict dstp{ reinterpret_cast<float*>(dst->GetWritePtr(plane)) + y0 * stride };
 
-                const auto& c02{ load<T>(&pfp[_maxr][x + 8]) };
-                const auto& srcp_v02{ load<T>(&srcp[_maxr][x + 8]) };
+    if (guide)
+        guide += y0 * guide_stride(width);
 
-                Vec8f weights01{ _cw };
-                auto sum01{ to_float(srcp_v01) * weights01 };
+    const int l{ plane >> 1 };
+    const float* const weightSaved{ _weight[l].data() };
+    const Vec8f thresh{ _threshF[l] };
+    const int tile{ (_tile > 0) ? _tile : width };
+    const bool nt{ _tile > 0 && !(reinterpret_cast<uintptr_t>(dstp) & 63) && !((stride * 4) & 63) };
 
-                Vec8f weights02{ _cw };
-                auto sum02{ to_float(srcp_v02) * weights02 };
+    for (int x0{ 0 }; x0 < static_cast<int>(width); x0 += tile)
+    {
+        const int x1{ std::min(x0 + tile, width) };
 
-                int frameIndex{ _maxr - 1 };
+        for (int y{ 0 }; y < height; ++y)
+        {
+            if (_tile > 0)
+                prefetch_next_row<float, diameter, pfclip>(srcp, pfp, src_stride, pf_stride, x0, x1);
 
-                if (frameIndex > fromFrame)
-                {
-                    auto t1_01{ load<T>(&pfp[frameIndex][x]) };
-                    auto diff01{ abs(c01 - t1_01) };
-                    const auto check_v01{ diff01 < thresh };
+            for (int x{ x0 }; x < x1; x += 8)
+            {
+                const auto c{ Vec8f().load(&pfp[maxr][x]) };
+                const auto srcp_v{ (pfclip) ? Vec8f().load(&srcp[maxr][x]) : c };
 
-                    auto t1_02{ load<T>(&pfp[frameIndex][x + 8]) };
-                    auto diff02{ abs(c02 - t1_02) };
-                    const auto check_v02{ diff02 < thresh };
+                Vec8f weights{ _cw };
+                auto sum{ srcp_v * weights };
+                Vec8i accepted{ 0 };
+                Vec8f bucket{ 0.0f };
 
-                    auto weight01{ (useDiff) ? lookup<1792>(diff01 >> _shift, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved) };
-                    auto weight02{ (useDiff) ? lookup<1792>(diff02 >> _shift, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved) };
+                int frameIndex{ maxr - 1 };
 
-                    weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
-                    weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
+                if (frameIndex > fromFrame)
+                {
+                    auto t1{ Vec8f().load(&pfp[frameIndex][x]) };
+                    auto diff{ min(abs(c - t1), 1.0f) };
+                    auto check_v{ diff < thresh };
 
-                    sum01 = select(Vec8fb(check_v01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                    sum02 = select(Vec8fb(check_v02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight02, sum02), sum02);
+                    auto weight{ (useDiff) ? lookup<256 * maxr>(truncatei(diff * 255.0f), weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved) };
+                    weights = select(check_v, weights + weight, weights);
+                    accepted = if_add(Vec8ib(check_v), accepted, Vec8i(1 << frameIndex));
+                    bucket = select(check_v, max(bucket, diff), bucket);
+                    sum = select(check_v, mul_add((pfclip) ? Vec8f().load(&srcp[frameIndex][x]) : t1, weight, sum), sum);
 
                     --frameIndex;
                     int v{ 256 };
 
-                    while (frameIndex > fromFrame)
+                    if constexpr (maxr > 1)
                     {
-                        const auto& t2_01{ t1_01 };
-                        t1_01 = load<T>(&pfp[frameIndex][x]);
-                        diff01 = abs(c01 - t1_01);
-                        const auto check_v1_01{ diff01 < thresh&& abs(t1_01 - t2_01) < thresh };
-
-                        const auto& t2_02{ t1_02 };
-                        t1_02 = load<T>(&pfp[frameIndex][x + 8]);
-                        diff02 = abs(c02 - t1_02);
-                        const auto check_v1_02{ diff02 < thresh&& abs(t1_02 - t2_02) < thresh };
-
-                        weight01 = (useDiff) ? lookup<1792>((diff01 >> _shift) + v, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved);
-                        weight02 = (useDiff) ? lookup<1792>((diff02 >> _shift) + v, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved);
-
-                        weights01 = select(Vec8fb(check_v1_01), weights01 + weight01, weights01);
-                        weights02 = select(Vec8fb(check_v1_02), weights02 + weight02, weights02);
-
-                        sum01 = select(Vec8fb(check_v1_01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                        sum02 = select(Vec8fb(check_v1_02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight02, sum02), sum02);
-
-                        --frameIndex;
-                        v += 256;
+                        while (frameIndex > fromFrame)
+                        {
+                            const auto t2{ t1 };
+                            t1 = Vec8f().load(&pfp[frameIndex][x]);
+                            diff = min(abs(c - t1), 1.0f);
+                            check_v = check_v && diff < thresh && min(abs(t1 - t2), 1.0f) < thresh;
+
+                            if (!horizontal_or(check_v))
+                                break;
+
+                            weight = (useDiff) ? lookup<256 * maxr>(truncatei(diff * 255.0f) + v, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved);
+                            weights = select(check_v, weights + weight, weights);
+                            accepted = if_add(Vec8ib(check_v), accepted, Vec8i(1 << frameIndex));
+                            bucket = select(check_v, max(bucket, diff), bucket);
+                            sum = select(check_v, mul_add((pfclip) ? Vec8f().load(&srcp[frameIndex][x]) : t1, weight, sum), sum);
+
+                            --frameIndex;
+                            v += 256;
+                        }
                     }
                 }
 
-                frameIndex = _maxr + 1;
+                frameIndex = maxr + 1;
 
                 if (frameIndex < toFrame)
                 {
-                    auto t1_01{ load<T>(&pfp[frameIndex][x]) };
-                    auto diff01{ abs(c01 - t1_01) };
-                    const auto check_v01{ diff01 < thresh };
+                    auto t1{ Vec8f().load(&pfp[frameIndex][x]) };
+                    auto diff{ min(abs(c - t1), 1.0f) };
+                    auto check_v{ diff < thresh };
 
-                    auto t1_02{ load<T>(&pfp[frameIndex][x + 8]) };
-                    auto diff02{ abs(c02 - t1_02) };
-                    const auto check_v02{ diff02 < thresh };
-
-                    auto weight01{ (useDiff) ? lookup<1792>(diff01 >> _shift, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved) };
-                    auto weight02{ (useDiff) ? lookup<1792>(diff02 >> _shift, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved) };
-
-                    weights01 = select(Vec8fb(check_v01), weights01 + weight01, weights01);
-                    weights02 = select(Vec8fb(check_v02), weights02 + weight02, weights02);
-
-                    sum01 = select(Vec8fb(check_v01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                    sum02 = select(Vec8fb(check_v02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight02, sum02), sum02);
+                    auto weight{ (useDiff) ? lookup<256 * maxr>(truncatei(diff * 255.0f), weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved) };
+                    weights = select(check_v, weights + weight, weights);
+                    accepted = if_add(Vec8ib(check_v), accepted, Vec8i(1 << frameIndex));
+                    bucket = select(check_v, max(bucket, diff), bucket);
+                    sum = select(check_v, mul_add((pfclip) ? Vec8f().load(&srcp[frameIndex][x]) : t1, weight, sum), sum);
 
                     ++frameIndex;
                     int v{ 256 };
 
-                    while (frameIndex < toFrame)
+                    if constexpr (maxr > 1)
                     {
-                        const auto& t2_01{ t1_01 };
-                        t1_01 = load<T>(&pfp[frameIndex][x]);
-                        diff01 = abs(c01 - t1_01);
-                        const auto check_v1_01{ diff01 < thresh&& abs(t1_01 - t2_01) < thresh };
-
-                        const auto& t2_02{ t1_02 };
-                        t1_02 = load<T>(&pfp[frameIndex][x + 8]);
-                        diff02 = abs(c02 - t1_02);
-                        const auto check_v1_02{ diff02 < thresh&& abs(t1_02 - t2_02) < thresh };
-
-                        weight01 = (useDiff) ? lookup<1792>((diff01 >> _shift) + v, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved);
-                        weight02 = (useDiff) ? lookup<1792>((diff02 >> _shift) + v, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved);
-
-                        weights01 = select(Vec8fb(check_v1_01), weights01 + weight01, weights01);
-                        weights02 = select(Vec8fb(check_v1_02), weights02 + weight02, weights02);
-
-                        sum01 = select(Vec8fb(check_v1_01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                        sum02 = select(Vec8fb(check_v1_02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight02, sum02), sum02);
-
-                        ++frameIndex;
-                        v += 256;
+                        while (frameIndex < toFrame)
+                        {
+                            const auto t2{ t1 };
+                            t1 = Vec8f().load(&pfp[frameIndex][x]);
+                            diff = min(abs(c - t1), 1.0f);
+                            check_v = check_v && diff < thresh && min(abs(t1 - t2), 1.0f) < thresh;
+
+                            if (!horizontal_or(check_v))
+                                break;
+
+                            weight = (useDiff) ? lookup<256 * maxr>(truncatei(diff * 255.0f) + v, weightSaved) : lookup<256 * maxr>(Vec8i(frameIndex), weightSaved);
+                            weights = select(check_v, weights + weight, weights);
+                            accepted = if_add(Vec8ib(check_v), accepted, Vec8i(1 << frameIndex));
+                            bucket = select(check_v, max(bucket, diff), bucket);
+                            sum = select(check_v, mul_add((pfclip) ? Vec8f().load(&srcp[frameIndex][x]) : t1, weight, sum), sum);
+
+                            ++frameIndex;
+                            v += 256;
+                        }
                     }
                 }
 
                 if constexpr (fp)
-                {
-                    compress_saturated_s2u(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x])), (1.0f - weights01), sum01 + 0.5f)), zero_si256()).get_low().store(dstp + x);
-                    compress_saturated_s2u(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x + 8])), (1.0f - weights02), sum02 + 0.5f)), zero_si256()).get_low().store(dstp + (x + 8));
-                }
+                    store(mul_add((pfclip) ? Vec8f().load(&srcp[maxr][x]) : c, (1.0f - weights), sum), dstp + x, nt);
                 else
-                {
-                    compress_saturated_s2u(truncatei(sum01 / weights01 + 0.5f), zero_si256()).get_low().store(dstp + x);
-                    compress_saturated_s2u(truncatei(sum02 / weights02 + 0.5f), zero_si256()).get_low().store(dstp + (x + 8));
-                }
+                    store(sum / weights, dstp + x, nt);
+
+                if (guide)
+                    (accepted | (truncatei(bucket * 255.0f) << 16)).store(guide + x);
             }
 
-            for (int i{ 0 }; i < _diameter; ++i)
+            for (int i{ 0 }; i < diameter; ++i)
             {
                 srcp[i] += src_stride[i];
                 pfp[i] += pf_stride[i];
             }
 
             dstp += stride;
+
+            if (guide)
+                guide += guide_stride(width);
         }
+
+        for (int i{ 0 }; i < diameter; ++i)
+        {
+            srcp[i] -= src_stride[i] * height;
+            pfp[i] -= pf_stride[i] * height;
+        }
+
+        dstp -= stride * height;
+
+        if (guide)
+            guide -= guide_stride(width) * height;
     }
+
+    if (nt)
+        _mm_sfence();
 }
 
-template void TTempSmooth<true, true>::filterI_avx2<uint8_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterI_avx2<uint8_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, true>::filterI_avx2<uint8_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterI_avx2<uint8_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterI_guided_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const uint32_t* guide, const int plane, const int y0, const int y1) noexcept
+{
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
+    const size_t stride{ dst->GetPitch(plane) / sizeof(T) };
+    const size_t width{ dst->GetRowSize(plane) / sizeof(T) };
+    const T* srcp[diameter]{};
+    for (int i{ 0 }; i < diameter; ++i)
+    {
+        src_stride[i] = src[i]->GetPitch(plane) / sizeof(T);
+        srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane)) + y0 * src_stride[i];
+    }
+
+    T* __restrict dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) + y0 * stride };
+    guide += y0 * guide_stride(width);
+
+    const float* const weightSaved{ _weight[plane >> 1].data() };
+
+    for (int y{ y0 }; y < y1; ++y)
+    {
+        for (size_t x{ 0 }; x < width; x += 8)
+        {
+            const auto accepted{ Vec8i().load(guide + x) };
+            const auto bucket{ accepted >> 16 };
+            const auto c{ to_float(load<T>(&srcp[maxr][x])) };
+
+            Vec8f weights{ _cw };
+            auto sum{ c * weights };
+
+            for (int i{ 0 }; i < diameter; ++i)
+            {
+                if (i == maxr)
+                    continue;
 
-template void TTempSmooth<false, true>::filterI_avx2<uint8_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterI_avx2<uint8_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, true>::filterI_avx2<uint8_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterI_avx2<uint8_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+                const auto check_v{ Vec8fb((accepted & (1 << i)) != 0) };
+                const auto weight{ (useDiff) ? lookup<256 * maxr>(bucket + 256 * (std::abs(i - maxr) - 1), weightSaved) : Vec8f(weightSaved[i]) };
+                weights = select(check_v, weights + weight, weights);
+                sum = select(check_v, mul_add(to_float(load<T>(&srcp[i][x])), weight, sum), sum);
+            }
 
-template void TTempSmooth<true, true>::filterI_avx2<uint16_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterI_avx2<uint16_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, true>::filterI_avx2<uint16_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterI_avx2<uint16_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+            const auto out{ truncatei((fp) ? mul_add(c, (1.0f - weights), sum + 0.5f) : sum / weights + 0.5f) };
 
-template void TTempSmooth<false, true>::filterI_avx2<uint16_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterI_avx2<uint16_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, true>::filterI_avx2<uint16_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterI_avx2<uint16_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+            if constexpr (std::is_same_v<T, uint8_t>)
+                compress_saturated_s2u(compress_saturated(out, zero_si256()), zero_si256()).get_low().storel(dstp + x);
+            else
+                compress_saturated_s2u(out, zero_si256()).get_low().store(dstp + x);
+        }
 
+        for (int i{ 0 }; i < diameter; ++i)
+            srcp[i] += src_stride[i];
+
+        dstp += stride;
+        guide += guide_stride(width);
+    }
+}
 
 template <bool pfclip, bool fp>
-template <bool useDiff>
-void TTempSmooth<pfclip, fp>::filterF_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept
+template <bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterF_guided_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const uint32_t* guide, const int plane, const int y0, const int y1) noexcept
 {
-    int src_stride[15]{};
-    int pf_stride[15]{};
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
     const int stride{ dst->GetPitch(plane) / 4 };
     const int width{ dst->GetRowSize(plane) / 4 };
-    const int height{ dst->GetHeight(plane) };
-    const float* srcp[15]{}, * pfp[15]{};
-    for (int i{ 0 }; i < _diameter; ++i)
+    const float* srcp[diameter]{};
+    for (int i{ 0 }; i < diameter; ++i)
     {
         src_stride[i] = src[i]->GetPitch(plane) / 4;
-        pf_stride[i] = pf[i]->GetPitch(plane) / 4;
-        srcp[i] = reinterpret_cast<const float*>(src[i]->GetReadPtr(plane));
-        pfp[i] = reinterpret_cast<const float*>(pf[i]->GetReadPtr(plane));
+        srcp[i] = reinterpret_cast<const float*>(src[i]->GetReadPtr(plane)) + y0 * src_stride[i];
     }
 
-    float* __restrict dstp{ reinterpret_cast<float*>(dst->GetWritePtr(plane)) };
+    float* __restrict dstp{ reinterpret_cast<float*>(dst->GetWritePtr(plane)) + y0 * stride };
+    guide += y0 * guide_stride(width);
 
-    const int l{ plane >> 1 };
-    const float* const weightSaved{ _weight[l].data() };
-    const Vec8f thresh{ _threshF[l] };
+    const float* const weightSaved{ _weight[plane >> 1].data() };
 
-    for (int y{ 0 }; y < height; ++y)
+    for (int y{ y0 }; y < y1; ++y)
     {
         for (int x{ 0 }; x < width; x += 8)
         {
-            const auto& c{ Vec8f().load(&pfp[_maxr][x]) };
-            const auto& srcp_v{ Vec8f().load(&srcp[_maxr][x]) };
+            const auto accepted{ Vec8i().load(guide + x) };
+            const auto bucket{ accepted >> 16 };
+            const auto c{ Vec8f().load(&srcp[maxr][x]) };
 
             Vec8f weights{ _cw };
-            auto sum{ srcp_v * weights };
+            auto sum{ c * weights };
 
-            int frameIndex{ _maxr - 1 };
-
-            if (frameIndex > fromFrame)
+            for (int i{ 0 }; i < diameter; ++i)
             {
-                auto t1{ Vec8f().load(&pfp[frameIndex][x]) };
-                auto diff{ min(abs(c - t1), 1.0f) };
-                const auto check_v{ diff < thresh };
+                if (i == maxr)
+                    continue;
 
-                auto weight{ (useDiff) ? lookup<1792>(truncatei(diff * 255.0f), weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved) };
+                const auto check_v{ Vec8fb((accepted & (1 << i)) != 0) };
+                const auto weight{ (useDiff) ? lookup<256 * maxr>(bucket + 256 * (std::abs(i - maxr) - 1), weightSaved) : Vec8f(weightSaved[i]) };
                 weights = select(check_v, weights + weight, weights);
-                sum = select(check_v, mul_add(Vec8f().load(&srcp[frameIndex][x]), weight, sum), sum);
+                sum = select(check_v, mul_add(Vec8f().load(&srcp[i][x]), weight, sum), sum);
+            }
+
+            if constexpr (fp)
+                mul_add(c, (1.0f - weights), sum).store(dstp + x);
+            else
+                (sum / weights).store(dstp + x);
+        }
+
+        for (int i{ 0 }; i < diameter; ++i)
+            srcp[i] += src_stride[i];
+
+        dstp += stride;
+        guide += guide_stride(width);
+    }
+}
+
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterUV_avx2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int y0, const int y1) noexcept
+{
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
+    int pf_stride[diameter]{};
+    // U and V of a frame share the pitch
+    const size_t stride{ dst->GetPitch(PLANAR_U) / sizeof(T) };
+    const size_t width{ dst->GetRowSize(PLANAR_U) / sizeof(T) };
+    const int height{ y1 - y0 };
+    const T* srcp[2][diameter]{}, * pfp[2][diameter]{};
+
+    for (int i{ 0 }; i < diameter; ++i)
+    {
+        src_stride[i] = src[i]->GetPitch(PLANAR_U) / sizeof(T);
+        pf_stride[i] = pf[i]->GetPitch(PLANAR_U) / sizeof(T);
+        srcp[0][i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(PLANAR_U)) + y0 * src_stride[i];
+        srcp[1][i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(PLANAR_V)) + y0 * src_stride[i];
+        pfp[0][i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(PLANAR_U)) + y0 * pf_stride[i];
+        pfp[1][i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(PLANAR_V)) + y0 * pf_stride[i];
+    }
+
+    T* __restrict dstp[2]{ reinterpret_cast<T*>(dst->GetWritePtr(PLANAR_U)) + y0 * stride, reinterpret_cast<T*>(dst->GetWritePtr(PLANAR_V)) + y0 * stride };
+
+    typedef std::conditional_t<std::is_integral_v<T>, Vec8i, Vec8f> vec_t;
+
+    const int shift{ (std::is_same_v<T, uint8_t>) ? 0 : _shift };
+    const vec_t thresh[2]{ (std::is_integral_v<T>) ? vec_t(_thresh[1] << shift) : vec_t(_threshF[1]), (std::is_integral_v<T>) ? vec_t(_thresh[2] << shift) : vec_t(_threshF[2]) };
+    const float* const weightSaved[2]{ _weight[1].data(), _weight[2].data() };
+
+    for (int y{ 0 }; y < height; ++y)
+    {
+        for (size_t x{ 0 }; x < width; x += 16)
+        {
+            // four independent accumulators: 16 samples of U and of V; each lane's chain breaks like filterUV
+            vec_t c[4];
+            Vec8f weights[4], sum[4];
+
+            for (int k{ 0 }; k < 4; ++k)
+            {
+                c[k] = load_vec(&pfp[k >> 1][maxr][x + (k & 1) * 8]);
+                weights[k] = _cw;
+                sum[k] = as_float((pfclip) ? load_vec(&srcp[k >> 1][maxr][x + (k & 1) * 8]) : c[k]) * weights[k];
+            }
 
-                --frameIndex;
-                int v{ 256 };
+            for (int dir{ -1 }; dir <= 1; dir += 2)
+            {
+                // the first step's continuity check against the center is its difference check
+                vec_t t2[4]{ c[0], c[1], c[2], c[3] };
+                Vec8fb chain[4]{ true, true, true, true };
+                int v{ 0 };
 
-                while (frameIndex > fromFrame)
+                for (int frameIndex{ maxr + dir }; (dir < 0) ? frameIndex > fromFrame : frameIndex < toFrame; frameIndex += dir)
                 {
-                    const auto& t2{ t1 };
-                    t1 = Vec8f().load(&pfp[frameIndex][x]);
-                    diff = min(abs(c - t1), 1.0f);
-                    const auto check_v1{ diff < thresh&& min(abs(t1 - t2), 1.0f) < thresh };
+                    for (int k{ 0 }; k < 4; ++k)
+                    {
+                        const auto t1{ load_vec(&pfp[k >> 1][frameIndex][x + (k & 1) * 8]) };
+                        Vec8f weight;
+
+                        if constexpr (std::is_integral_v<T>)
+                        {
+                            const auto diff{ abs(c[k] - t1) };
+                            chain[k] = chain[k] && Vec8fb(diff < thresh[k >> 1] && abs(t1 - t2[k]) < thresh[k >> 1]);
+                            weight = (useDiff) ? lookup<256 * maxr>((diff >> shift) + v, weightSaved[k >> 1]) : Vec8f(weightSaved[k >> 1][frameIndex]);
+                        }
+                        else
+                        {
+                            const auto diff{ min(abs(c[k] - t1), 1.0f) };
+                            chain[k] = chain[k] && diff < thresh[k >> 1] && min(abs(t1 - t2[k]), 1.0f) < thresh[k >> 1];
+                            weight = (useDiff) ? lookup<256 * maxr>(truncatei(diff * 255.0f) + v, weightSaved[k >> 1]) : Vec8f(weightSaved[k >> 1][frameIndex]);
+                        }
+
+                        weights[k] = select(chain[k], weights[k] + weight, weights[k]);
+                        sum[k] = select(chain[k], mul_add(as_float((pfclip) ? load_vec(&srcp[k >> 1][frameIndex][x + (k & 1) * 8]) : t1), weight, sum[k]), sum[k]);
+                        t2[k] = t1;
+                    }
 
-                    weight = (useDiff) ? lookup<1792>(truncatei(diff * 255.0f) + v, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved);
-                    weights = select(check_v1, weights + weight, weights);
-                    sum = select(check_v1, mul_add(Vec8f().load(&srcp[frameIndex][x]), weight, sum), sum);
+                    if (!horizontal_or(chain[0] | chain[1] | chain[2] | chain[3]))
+                        break;
 
-                    --frameIndex;
                     v += 256;
                 }
             }
 
-            frameIndex = _maxr + 1;
-
-            if (frameIndex < toFrame)
+            for (int k{ 0 }; k < 4; ++k)
             {
-                auto t1{ Vec8f().load(&pfp[frameIndex][x]) };
-                auto diff{ min(abs(c - t1), 1.0f) };
-                const auto check_v{ diff < thresh };
+                T* const out{ dstp[k >> 1] + x + (k & 1) * 8 };
+                const auto center{ as_float((pfclip) ? load_vec(&srcp[k >> 1][maxr][x + (k & 1) * 8]) : c[k]) };
 
-                auto weight{ (useDiff) ? lookup<1792>(truncatei(diff * 255.0f), weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved) };
-                weights = select(check_v, weights + weight, weights);
-                sum = select(check_v, mul_add(Vec8f().load(&srcp[frameIndex][x]), weight, sum), sum);
+                if constexpr (std::is_same_v<T, float>)
+                {
+                    if constexpr (fp)
+                        mul_add(center, (1.0f - weights[k]), sum[k]).store(out);
+                    else
+                        (sum[k] / weights[k]).store(out);
+                }
+                else
+                {
+                    const auto result{ truncatei((fp) ? mul_add(center, (1.0f - weights[k]), sum[k] + 0.5f) : sum[k] / weights[k] + 0.5f) };
 
-                ++frameIndex;
-                int v{ 256 };
+                    if constexpr (std::is_same_v<T, uint8_t>)
+                        compress_saturated_s2u(compress_saturated(result, zero_si256()), zero_si256()).get_low().storel(out);
+                    else
+                        compress_saturated_s2u(result, zero_si256()).get_low().store(out);
+                }
+            }
+        }
 
-                while (frameIndex < toFrame)
-                {
-                    const auto& t2{ t1 };
-                    t1 = Vec8f().load(&pfp[frameIndex][x]);
-                    diff = min(abs(c - t1), 1.0f);
-                    const auto check_v1{ diff < thresh&& min(abs(t1 - t2), 1.0f) < thresh };
+        for (int i{ 0 }; i < diameter; ++i)
+        {
+            srcp[0][i] += src_stride[i];
+            srcp[1][i] += src_stride[i];
+            pfp[0][i] += pf_stride[i];
+            pfp[1][i] += pf_stride[i];
+        }
 
-                    weight = (useDiff) ? lookup<1792>(truncatei(diff * 255.0f) + v, weightSaved) : lookup<1792>(Vec8i(frameIndex), weightSaved);
-                    weights = select(check_v1, weights + weight, weights);
-                    sum = select(check_v1, mul_add(Vec8f().load(&srcp[frameIndex][x]), weight, sum), sum);
+        dstp[0] += stride;
+        dstp[1] += stride;
+    }
+}
 
-                    ++frameIndex;
-                    v += 256;
-                }
+template <bool pfclip, bool fp>
+template <typename T>
+void TTempSmooth<pfclip, fp>::filter_recursive_avx2(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane)
+{
+    const size_t stride{ dst->GetPitch(plane) / sizeof(T) };
+    const size_t width{ dst->GetRowSize(plane) / sizeof(T) };
+    const int height{ dst->GetHeight(plane) };
+    const int l{ plane >> 1 };
+    size_t src_stride[3];
+    size_t pf_stride[3];
+    const T* g_srcp[3];
+    const T* g_pfp[3];
+
+    for (int i{ 0 }; i < 3; ++i)
+    {
+        src_stride[i] = src[i]->GetPitch(plane) / sizeof(T);
+        pf_stride[i] = pf[i]->GetPitch(plane) / sizeof(T);
+        g_srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane));
+        g_pfp[i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(plane));
+    }
+
+    T* g_dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) };
+
+    const Vec8f thresh((std::is_same_v<T, float>) ? _threshF[l] : static_cast<float>(_thresh[l] << _shift));
+    const Vec8f scale((std::is_same_v<T, float>) ? 255.0f : 1.0f / (1 << _shift));
+    const Vec8f decay(_decay);
+    const float* weight{ _weight[l].data() };
+    const bool reset{ fromFrame >= 1 };
+    const bool next{ toFrame > 2 };
+
+    float* g_state{ reinterpret_cast<float*>(pIIRMem[l].data()) };
+    constexpr int fields{ (pfclip) ? 3 : 2 };
+    const size_t state_width{ recursive_stride(width) };
+
+    const thread_budget budget(_threads);
+
+#pragma omp parallel for num_threads(budget.threads())
+    for (int y = 0; y < height; ++y)
+    {
+        const T* prevp{ g_pfp[0] + y * pf_stride[0] };
+        const T* srcp{ g_srcp[1] + y * src_stride[1] };
+        const T* pfp{ g_pfp[1] + y * pf_stride[1] };
+        const T* nextp{ g_srcp[2] + y * src_stride[2] };
+        const T* next_pfp{ g_pfp[2] + y * pf_stride[2] };
+        T* dstp{ g_dstp + y * stride };
+        float* acc{ g_state + y * state_width * fields };
+        float* wsum{ acc + state_width };
+        float* acc_pf{ (pfclip) ? wsum + state_width : acc };
+
+        for (size_t x{ 0 }; x < width; x += 8)
+        {
+            const Vec8f c{ as_float(load_vec(srcp + x)) };
+            const Vec8f c_pf{ as_float(load_vec(pfp + x)) };
+            Vec8f sum{ c };
+            Vec8f weights(1.0f);
+            Vec8f sum_pf{ c_pf };
+
+            if (!reset)
+            {
+                const Vec8f a{ Vec8f().load(acc + x) };
+                const Vec8f w{ Vec8f().load(wsum + x) };
+                const Vec8f a_pf{ (pfclip) ? Vec8f().load(acc_pf + x) : a };
+                const Vec8f diff_prev{ abs(c_pf - as_float(load_vec(prevp + x))) };
+                const Vec8f diff{ abs(c_pf - a_pf / w) };
+                // an index past the table belongs to a lane that fails the motion test
+                const Vec8f k{ select((diff_prev < thresh) & (diff < thresh), decay * lookup<256>(truncatei(diff * scale), weight), 0.0f) };
+
+                sum = mul_add(k, a, c);
+                weights = mul_add(k, w, 1.0f);
+
+                if constexpr (pfclip)
+                    sum_pf = mul_add(k, a_pf, c_pf);
             }
 
-            if constexpr (fp)
-                mul_add(Vec8f().load(&srcp[_maxr][x]), (1.0f - weights), sum).store(dstp + x);
-            else
+            sum.store(acc + x);
+            weights.store(wsum + x);
+
+            if constexpr (pfclip)
+                sum_pf.store(acc_pf + x);
+
+            if (next)
+            {
+                const Vec8f diff{ abs(as_float(load_vec(next_pfp + x)) - c_pf) };
+                const Vec8f w{ select(diff < thresh, decay * lookup<256>(truncatei(diff * scale), weight), 0.0f) };
+
+                sum = mul_add(w, as_float(load_vec(nextp + x)), sum);
+                weights += w;
+            }
+
+            if constexpr (std::is_same_v<T, float>)
                 (sum / weights).store(dstp + x);
+            else
+            {
+                const Vec8i result{ truncatei(sum / weights + 0.5f) };
+
+                if constexpr (std::is_same_v<T, uint8_t>)
+                    compress_saturated_s2u(compress_saturated(result, zero_si256()), zero_si256()).get_low().storel(dstp + x);
+                else
+                    compress_saturated_s2u(result, zero_si256()).get_low().store(dstp + x);
+            }
         }
+    }
+}
 
-        for (int i{ 0 }; i < _diameter; ++i)
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff>
+typename TTempSmooth<pfclip, fp>::filter_t TTempSmooth<pfclip, fp>::get_filter_avx2() const noexcept
+{
+    if constexpr (std::is_same_v<T, float>)
+    {
+        switch (_maxr)
         {
-            srcp[i] += src_stride[i];
-            pfp[i] += pf_stride[i];
+            case 1: return &TTempSmooth::filterF_avx2<useDiff, 1>;
+            case 2: return &TTempSmooth::filterF_avx2<useDiff, 2>;
+            case 3: return &TTempSmooth::filterF_avx2<useDiff, 3>;
+            case 4: return &TTempSmooth::filterF_avx2<useDiff, 4>;
+            case 5: return &TTempSmooth::filterF_avx2<useDiff, 5>;
+            case 6: return &TTempSmooth::filterF_avx2<useDiff, 6>;
+            default: return &TTempSmooth::filterF_avx2<useDiff, 7>;
         }
+    }
+    else
+    {
+        switch (_maxr)
+        {
+            case 1: return &TTempSmooth::filterI_avx2<T, useDiff, 1>;
+            case 2: return &TTempSmooth::filterI_avx2<T, useDiff, 2>;
+            case 3: return &TTempSmooth::filterI_avx2<T, useDiff, 3>;
+            case 4: return &TTempSmooth::filterI_avx2<T, useDiff, 4>;
+            case 5: return &TTempSmooth::filterI_avx2<T, useDiff, 5>;
+            case 6: return &TTempSmooth::filterI_avx2<T, useDiff, 6>;
+            default: return &TTempSmooth::filterI_avx2<T, useDiff, 7>;
+        }
+    }
+}
 
-        dstp += stride;
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_avx2<uint8_t, false>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_avx2<uint8_t, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_avx2<uint8_t, false>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_avx2<uint8_t, false>() const noexcept;
+
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_avx2<uint16_t, false>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_avx2<uint16_t, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_avx2<uint16_t, false>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_avx2<uint16_t, false>() const noexcept;
+
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_avx2<float, true>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_avx2<float, true>() const noexcept;
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_avx2<float, false>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_avx2<float, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_avx2<float, true>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_avx2<float, true>() const noexcept;
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_avx2<float, false>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_avx2<float, false>() const noexcept;
+
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff>
+typename TTempSmooth<pfclip, fp>::filter_uv_t TTempSmooth<pfclip, fp>::get_filter_uv_avx2() const noexcept
+{
+    switch (_maxr)
+    {
+        case 1: return &TTempSmooth::filterUV_avx2<T, useDiff, 1>;
+        case 2: return &TTempSmooth::filterUV_avx2<T, useDiff, 2>;
+        case 3: return &TTempSmooth::filterUV_avx2<T, useDiff, 3>;
+        case 4: return &TTempSmooth::filterUV_avx2<T, useDiff, 4>;
+        case 5: return &TTempSmooth::filterUV_avx2<T, useDiff, 5>;
+        case 6: return &TTempSmooth::filterUV_avx2<T, useDiff, 6>;
+        default: return &TTempSmooth::filterUV_avx2<T, useDiff, 7>;
     }
 }
 
-template void TTempSmooth<true, true>::filterF_avx2<true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterF_avx2<true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, true>::filterF_avx2<false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterF_avx2<false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff>
+typename TTempSmooth<pfclip, fp>::filter_guided_t TTempSmooth<pfclip, fp>::get_filter_guided_avx2() const noexcept
+{
+    if constexpr (std::is_same_v<T, float>)
+    {
+        switch (_maxr)
+        {
+            case 1: return &TTempSmooth::filterF_guided_avx2<useDiff, 1>;
+            case 2: return &TTempSmooth::filterF_guided_avx2<useDiff, 2>;
+            case 3: return &TTempSmooth::filterF_guided_avx2<useDiff, 3>;
+            case 4: return &TTempSmooth::filterF_guided_avx2<useDiff, 4>;
+            case 5: return &TTempSmooth::filterF_guided_avx2<useDiff, 5>;
+            case 6: return &TTempSmooth::filterF_guided_avx2<useDiff, 6>;
+            default: return &TTempSmooth::filterF_guided_avx2<useDiff, 7>;
+        }
+    }
+    else
+    {
+        switch (_maxr)
+        {
+            case 1: return &TTempSmooth::filterI_guided_avx2<T, useDiff, 1>;
+            case 2: return &TTempSmooth::filterI_guided_avx2<T, useDiff, 2>;
+            case 3: return &TTempSmooth::filterI_guided_avx2<T, useDiff, 3>;
+            case 4: return &TTempSmooth::filterI_guided_avx2<T, useDiff, 4>;
+            case 5: return &TTempSmooth::filterI_guided_avx2<T, useDiff, 5>;
+            case 6: return &TTempSmooth::filterI_guided_avx2<T, useDiff, 6>;
+            default: return &TTempSmooth::filterI_guided_avx2<T, useDiff, 7>;
+        }
+    }
+}
 
-template void TTempSmooth<false, true>::filterF_avx2<true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterF_avx2<true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, true>::filterF_avx2<false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterF_avx2<false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+template TTempSmooth<true, true>::filter_uv_t TTempSmooth<true, true>::get_filter_uv_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<true, false>::filter_uv_t TTempSmooth<true, false>::get_filter_uv_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<true, true>::filter_uv_t TTempSmooth<true, true>::get_filter_uv_avx2<uint8_t, false>() const noexcept;
+template TTempSmooth<true, false>::filter_uv_t TTempSmooth<true, false>::get_filter_uv_avx2<uint8_t, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_uv_t TTempSmooth<false, true>::get_filter_uv_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<false, false>::filter_uv_t TTempSmooth<false, false>::get_filter_uv_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<false, true>::filter_uv_t TTempSmooth<false, true>::get_filter_uv_avx2<uint8_t, false>() const noexcept;
+template TTempSmooth<false, false>::filter_uv_t TTempSmooth<false, false>::get_filter_uv_avx2<uint8_t, false>() const noexcept;
+
+template TTempSmooth<true, true>::filter_uv_t TTempSmooth<true, true>::get_filter_uv_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<true, false>::filter_uv_t TTempSmooth<true, false>::get_filter_uv_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<true, true>::filter_uv_t TTempSmooth<true, true>::get_filter_uv_avx2<uint16_t, false>() const noexcept;
+template TTempSmooth<true, false>::filter_uv_t TTempSmooth<true, false>::get_filter_uv_avx2<uint16_t, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_uv_t TTempSmooth<false, true>::get_filter_uv_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<false, false>::filter_uv_t TTempSmooth<false, false>::get_filter_uv_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<false, true>::filter_uv_t TTempSmooth<false, true>::get_filter_uv_avx2<uint16_t, false>() const noexcept;
+template TTempSmooth<false, false>::filter_uv_t TTempSmooth<false, false>::get_filter_uv_avx2<uint16_t, false>() const noexcept;
+
+template TTempSmooth<true, true>::filter_uv_t TTempSmooth<true, true>::get_filter_uv_avx2<float, true>() const noexcept;
+template TTempSmooth<true, false>::filter_uv_t TTempSmooth<true, false>::get_filter_uv_avx2<float, true>() const noexcept;
+template TTempSmooth<true, true>::filter_uv_t TTempSmooth<true, true>::get_filter_uv_avx2<float, false>() const noexcept;
+template TTempSmooth<true, false>::filter_uv_t TTempSmooth<true, false>::get_filter_uv_avx2<float, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_uv_t TTempSmooth<false, true>::get_filter_uv_avx2<float, true>() const noexcept;
+template TTempSmooth<false, false>::filter_uv_t TTempSmooth<false, false>::get_filter_uv_avx2<float, true>() const noexcept;
+template TTempSmooth<false, true>::filter_uv_t TTempSmooth<false, true>::get_filter_uv_avx2<float, false>() const noexcept;
+template TTempSmooth<false, false>::filter_uv_t TTempSmooth<false, false>::get_filter_uv_avx2<float, false>() const noexcept;
+
+template TTempSmooth<true, true>::filter_guided_t TTempSmooth<true, true>::get_filter_guided_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<true, false>::filter_guided_t TTempSmooth<true, false>::get_filter_guided_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<true, true>::filter_guided_t TTempSmooth<true, true>::get_filter_guided_avx2<uint8_t, false>() const noexcept;
+template TTempSmooth<true, false>::filter_guided_t TTempSmooth<true, false>::get_filter_guided_avx2<uint8_t, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_guided_t TTempSmooth<false, true>::get_filter_guided_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<false, false>::filter_guided_t TTempSmooth<false, false>::get_filter_guided_avx2<uint8_t, true>() const noexcept;
+template TTempSmooth<false, true>::filter_guided_t TTempSmooth<false, true>::get_filter_guided_avx2<uint8_t, false>() const noexcept;
+template TTempSmooth<false, false>::filter_guided_t TTempSmooth<false, false>::get_filter_guided_avx2<uint8_t, false>() const noexcept;
+
+template TTempSmooth<true, true>::filter_guided_t TTempSmooth<true, true>::get_filter_guided_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<true, false>::filter_guided_t TTempSmooth<true, false>::get_filter_guided_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<true, true>::filter_guided_t TTempSmooth<true, true>::get_filter_guided_avx2<uint16_t, false>() const noexcept;
+template TTempSmooth<true, false>::filter_guided_t TTempSmooth<true, false>::get_filter_guided_avx2<uint16_t, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_guided_t TTempSmooth<false, true>::get_filter_guided_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<false, false>::filter_guided_t TTempSmooth<false, false>::get_filter_guided_avx2<uint16_t, true>() const noexcept;
+template TTempSmooth<false, true>::filter_guided_t TTempSmooth<false, true>::get_filter_guided_avx2<uint16_t, false>() const noexcept;
+template TTempSmooth<false, false>::filter_guided_t TTempSmooth<false, false>::get_filter_guided_avx2<uint16_t, false>() const noexcept;
+
+template TTempSmooth<true, true>::filter_guided_t TTempSmooth<true, true>::get_filter_guided_avx2<float, true>() const noexcept;
+template TTempSmooth<true, false>::filter_guided_t TTempSmooth<true, false>::get_filter_guided_avx2<float, true>() const noexcept;
+template TTempSmooth<true, true>::filter_guided_t TTempSmooth<true, true>::get_filter_guided_avx2<float, false>() const noexcept;
+template TTempSmooth<true, false>::filter_guided_t TTempSmooth<true, false>::get_filter_guided_avx2<float, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_guided_t TTempSmooth<false, true>::get_filter_guided_avx2<float, true>() const noexcept;
+template TTempSmooth<false, false>::filter_guided_t TTempSmooth<false, false>::get_filter_guided_avx2<float, true>() const noexcept;
+template TTempSmooth<false, true>::filter_guided_t TTempSmooth<false, true>::get_filter_guided_avx2<float, false>() const noexcept;
+template TTempSmooth<false, false>::filter_guided_t TTempSmooth<false, false>::get_filter_guided_avx2<float, false>() const noexcept;
+
+template void TTempSmooth<true, true>::filter_recursive_avx2<uint8_t>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<true, false>::filter_recursive_avx2<uint8_t>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<false, true>::filter_recursive_avx2<uint8_t>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<false, false>::filter_recursive_avx2<uint8_t>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+
+template void TTempSmooth<true, true>::filter_recursive_avx2<uint16_t>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<true, false>::filter_recursive_avx2<uint16_t>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<false, true>::filter_recursive_avx2<uint16_t>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<false, false>::filter_recursive_avx2<uint16_t>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+
+template void TTempSmooth<true, true>::filter_recursive_avx2<float>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<true, false>::filter_recursive_avx2<float>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<false, true>::filter_recursive_avx2<float>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<false, false>::filter_recursive_avx2<float>(PVideoFrame src[3], PVideoFrame pf[3], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
 
 template <typename T>
-float ComparePlane_avx2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept
+float ComparePlane_avx2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept
 {
     const size_t pitch{ src->GetPitch(PLANAR_Y) / sizeof(T) };
     const size_t pitch2{ src1->GetPitch(PLANAR_Y) / sizeof(T) };
@@ -543,28 +1269,70 @@ float ComparePlane_avx2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_
     const T* srcp{ reinterpret_cast<const T*>(src->GetReadPtr(PLANAR_Y)) };
     const T* srcp2{ reinterpret_cast<const T*>(src1->GetReadPtr(PLANAR_Y)) };
 
-    Vec8f accum{ 0.0f };
-
-    for (size_t y{ 0 }; y < height; ++y)
+    if constexpr (std::is_integral_v<T>)
     {
-        for (size_t x{ 0 }; x < width; x += 8)
+        // exact integer SAD; stops once the result is known to be above limit
+        const double norm{ static_cast<double>((1 << bits_per_pixel) - 1) * height * width };
+        const uint64_t sad_limit{ static_cast<uint64_t>(limit * norm) };
+        const size_t vec_width{ width & ~static_cast<size_t>(32 / sizeof(T) - 1) };
+        uint64_t sad{ 0 };
+
+        for (int y{ 0 }; y < height && sad <= sad_limit; ++y)
         {
-            if constexpr (std::is_integral_v<T>)
-                accum += abs(to_float(load<T>(&srcp[x])) - to_float(load<T>(&srcp2[x])));
+            if constexpr (std::is_same_v<T, uint8_t>)
+            {
+                Vec4uq accum{ 0 };
+
+                for (size_t x{ 0 }; x < vec_width; x += 32)
+                    accum += Vec4uq(_mm256_sad_epu8(Vec32uc().load(&srcp[x]), Vec32uc().load(&srcp2[x])));
+
+                sad += horizontal_add(accum);
+            }
             else
-                accum += abs(Vec8f().load(&srcp[x]) - Vec8f().load(&srcp2[x]));
+            {
+                Vec8ui accum{ 0 };
+
+                for (size_t x{ 0 }; x < vec_width; x += 16)
+                {
+                    const Vec16us a{ Vec16us().load(&srcp[x]) };
+                    const Vec16us b{ Vec16us().load(&srcp2[x]) };
+                    const Vec16us diff{ sub_saturated(a, b) | sub_saturated(b, a) };
+                    accum += extend_low(diff) + extend_high(diff);
+                }
+
+                sad += horizontal_add_x(accum);
+            }
+
+            for (size_t x{ vec_width }; x < width; ++x)
+                sad += std::abs(srcp[x] - srcp2[x]);
+
+            srcp += pitch;
+            srcp2 += pitch2;
         }
 
-        srcp += pitch;
-        srcp2 += pitch2;
+        return static_cast<float>(sad / norm);
     }
-
-    if constexpr (std::is_integral_v<T>)
-        return horizontal_add(accum / ((1 << bits_per_pixel) - 1)) / (height * width);
     else
+    {
+        const float accum_limit{ limit * height * width };
+        Vec8f accum{ 0.0f };
+
+        for (int y{ 0 }; y < height; ++y)
+        {
+            for (size_t x{ 0 }; x < width; x += 8)
+                accum += abs(Vec8f().load(&srcp[x]) - Vec8f().load(&srcp2[x]));
+
+            srcp += pitch;
+            srcp2 += pitch2;
+
+            if (horizontal_add(accum) > accum_limit)
+                break;
+        }
+
         return horizontal_add(accum) / (height * width);
+    }
 }
 
-template float ComparePlane_avx2<uint8_t>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
-template float ComparePlane_avx2<uint16_t>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
-template float ComparePlane_avx2<float>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
+template float ComparePlane_avx2<uint8_t>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
+template float ComparePlane_avx2<uint16_t>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
+template float ComparePlane_avx2<float>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
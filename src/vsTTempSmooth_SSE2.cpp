@@ -10,530 +10,664 @@ AVS_FORCEINLINE static Vec4i load(const void* p)
         return Vec4i().load_4us(p);
 }
 
+template <typename V, typename T>
+AVS_FORCEINLINE static void store(const V& v, T* p, const bool nt)
+{
+    if (nt)
+        v.store_nt(p);
+    else
+        v.store(p);
+}
+
 template <bool pfclip, bool fp>
-template <typename T, bool useDiff>
-void TTempSmooth<pfclip, fp>::filterI_sse2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept
+template <typename T, bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterI_sse2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept
 {
-    int src_stride[15]{};
-    int pf_stride[15]{};
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
+    int pf_stride[diameter]{};
     const size_t stride{ dst->GetPitch(plane) / sizeof(T) };
     const size_t width{ dst->GetRowSize(plane) / sizeof(T) };
-    const int height{ dst->GetHeight(plane) };
-    const T* srcp[15]{}, * pfp[15]{};
-    for (int i{ 0 }; i < _diameter; ++i)
+    const int height{ y1 - y0 };
+    const T* srcp[diameter]{}, * pfp[diameter]{};
+    for (int i{ 0 }; i < diameter; ++i)
     {
         src_stride[i] = src[i]->GetPitch(plane) / sizeof(T);
         pf_stride[i] = pf[i]->GetPitch(plane) / sizeof(T);
-        srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane));
-        pfp[i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(plane));
+        srcp[i] = reinterpret_cast<const T*>(src[i]->GetReadPtr(plane)) + y0 * src_stride[i];
+        pfp[i] = reinterpret_cast<const T*>(pf[i]->GetReadPtr(plane)) + y0 * pf_stride[i];
     }
 
-    T* __restrict dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) };
+    T* __restrict dstp{ reinterpret_cast<T*>(dst->GetWritePtr(plane)) + y0 * stride };
 
     const int l{ plane >> 1 };
+    const int shift{ (std::is_same_v<T, uint8_t>) ? 0 : _shift };
     const float* const weightSaved{ _weight[l].data() };
-    const Vec4i thresh{ _thresh[l] << _shift };
+    const Vec4i thresh{ _thresh[l] << shift };
+    const int tile{ (_tile > 0) ? _tile : static_cast<int>(width) };
 
     if constexpr (std::is_same_v<T, uint8_t>)
     {
-        for (int y{ 0 }; y < height; ++y)
+        for (int x0{ 0 }; x0 < static_cast<int>(width); x0 += tile)
         {
-            for (int x{ 0 }; x < width; x += 16)
+            const int x1{ std::min(x0 + tile, static_cast<int>(width)) };
+
+            for (int y{ 0 }; y < height; ++y)
             {
-                const auto& c01{ load<T>(&pfp[_maxr][x]) };
-                const auto& srcp_v01{ load<T>(&srcp[_maxr][x]) };
+                if (_tile > 0)
+                    prefetch_next_row<T, diameter, pfclip>(srcp, pfp, src_stride, pf_stride, x0, x1);
 
-                const auto& c02{ load<T>(&pfp[_maxr][x + 4]) };
-                const auto& srcp_v02{ load<T>(&srcp[_maxr][x + 4]) };
+                for (int x{ x0 }; x < x1; x += 16)
+                {
+                    const auto& c01{ load<T>(&pfp[maxr][x]) };
+                    const auto& srcp_v01{ (pfclip) ? load<T>(&srcp[maxr][x]) : c01 };
 
-                const auto& c03{ load<T>(&pfp[_maxr][x + 8]) };
-                const auto& srcp_v03{ load<T>(&srcp[_maxr][x + 8]) };
+                    const auto& c02{ load<T>(&pfp[maxr][x + 4]) };
+                    const auto& srcp_v02{ (pfclip) ? load<T>(&srcp[maxr][x + 4]) : c02 };
 
-                const auto& c04{ load<T>(&pfp[_maxr][x + 12]) };
-                const auto& srcp_v04{ load<T>(&srcp[_maxr][x + 12]) };
+                    const auto& c03{ load<T>(&pfp[maxr][x + 8]) };
+                    const auto& srcp_v03{ (pfclip) ? load<T>(&srcp[maxr][x + 8]) : c03 };
 
-                Vec4f weights01{ _cw };
-                auto sum01{ to_float(srcp_v01) * weights01 };
+                    const auto& c04{ load<T>(&pfp[maxr][x + 12]) };
+                    const auto& srcp_v04{ (pfclip) ? load<T>(&srcp[maxr][x + 12]) : c04 };
 
-                Vec4f weights02{ _cw };
-                auto sum02{ to_float(srcp_v02) * weights02 };
+                    Vec4f weights01{ _cw };
+                    auto sum01{ to_float(srcp_v01) * weights01 };
 
-                Vec4f weights03{ _cw };
-                auto sum03{ to_float(srcp_v03) * weights03 };
+                    Vec4f weights02{ _cw };
+                    auto sum02{ to_float(srcp_v02) * weights02 };
 
-                Vec4f weights04{ _cw };
-                auto sum04{ to_float(srcp_v04) * weights04 };
+                    Vec4f weights03{ _cw };
+                    auto sum03{ to_float(srcp_v03) * weights03 };
 
-                int frameIndex{ _maxr - 1 };
+                    Vec4f weights04{ _cw };
+                    auto sum04{ to_float(srcp_v04) * weights04 };
 
-                if (frameIndex > fromFrame)
-                {
-                    auto t1_01{ load<T>(&pfp[frameIndex][x]) };
-                    auto diff01{ abs(c01 - t1_01) };
-                    const auto check_v01{ diff01 < thresh };
+                    int frameIndex{ maxr - 1 };
 
-                    auto t1_02{ load<T>(&pfp[frameIndex][x + 4]) };
-                    auto diff02{ abs(c02 - t1_02) };
-                    const auto check_v02{ diff02 < thresh };
+                    if (frameIndex > fromFrame)
+                    {
+                        auto t1_01{ load<T>(&pfp[frameIndex][x]) };
+                        auto diff01{ abs(c01 - t1_01) };
+                        auto check_v01{ diff01 < thresh };
 
-                    auto t1_03{ load<T>(&pfp[frameIndex][x + 8]) };
-                    auto diff03{ abs(c03 - t1_03) };
-                    const auto check_v03{ diff03 < thresh };
+                        auto t1_02{ load<T>(&pfp[frameIndex][x + 4]) };
+                        auto diff02{ abs(c02 - t1_02) };
+                        auto check_v02{ diff02 < thresh };
 
-                    auto t1_04{ load<T>(&pfp[frameIndex][x + 12]) };
-                    auto diff04{ abs(c04 - t1_04) };
-                    const auto check_v04{ diff04 < thresh };
+                        auto t1_03{ load<T>(&pfp[frameIndex][x + 8]) };
+                        auto diff03{ abs(c03 - t1_03) };
+                        auto check_v03{ diff03 < thresh };
 
-                    auto weight01{ (useDiff) ? lookup<1792>(diff01 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight02{ (useDiff) ? lookup<1792>(diff02 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight03{ (useDiff) ? lookup<1792>(diff03 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight04{ (useDiff) ? lookup<1792>(diff04 >> _shift, weightSaved) : weightSaved[frameIndex] };
+                        auto t1_04{ load<T>(&pfp[frameIndex][x + 12]) };
+                        auto diff04{ abs(c04 - t1_04) };
+                        auto check_v04{ diff04 < thresh };
 
-                    weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
-                    weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
-                    weights03 = select(Vec4fb(check_v03), weights03 + weight03, weights03);
-                    weights04 = select(Vec4fb(check_v04), weights04 + weight04, weights04);
+                        auto weight01{ (useDiff) ? lookup<256 * maxr>(diff01 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight02{ (useDiff) ? lookup<256 * maxr>(diff02 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight03{ (useDiff) ? lookup<256 * maxr>(diff03 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight04{ (useDiff) ? lookup<256 * maxr>(diff04 >> shift, weightSaved) : weightSaved[frameIndex] };
 
-                    sum01 = select(Vec4fb(check_v01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                    sum02 = select(Vec4fb(check_v02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 4])), weight02, sum02), sum02);
-                    sum03 = select(Vec4fb(check_v03), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight03, sum03), sum03);
-                    sum04 = select(Vec4fb(check_v04), mul_add(to_float(load<T>(&srcp[frameIndex][x + 12])), weight04, sum04), sum04);
+                        weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
+                        weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
+                        weights03 = select(Vec4fb(check_v03), weights03 + weight03, weights03);
+                        weights04 = select(Vec4fb(check_v04), weights04 + weight04, weights04);
 
-                    --frameIndex;
-                    int v{ 256 };
-
-                    while (frameIndex > fromFrame)
-                    {
-                        const auto& t2_01{ t1_01 };
-                        t1_01 = load<T>(&pfp[frameIndex][x]);
-                        diff01 = abs(c01 - t1_01);
-                        const auto check_v1_01{ diff01 < thresh&& abs(t1_01 - t2_01) < thresh };
-
-                        const auto& t2_02{ t1_02 };
-                        t1_02 = load<T>(&pfp[frameIndex][x + 4]);
-                        diff02 = abs(c02 - t1_02);
-                        const auto check_v1_02{ diff02 < thresh&& abs(t1_02 - t2_02) < thresh };
-
-                        const auto& t2_03{ t1_03 };
-                        t1_03 = load<T>(&pfp[frameIndex][x + 8]);
-                        diff03 = abs(c03 - t1_03);
-                        const auto check_v1_03{ diff03 < thresh&& abs(t1_03 - t2_03) < thresh };
-
-                        const auto& t2_04{ t1_04 };
-                        t1_04 = load<T>(&pfp[frameIndex][x + 12]);
-                        diff04 = abs(c04 - t1_04);
-                        const auto check_v1_04{ diff04 < thresh&& abs(t1_04 - t2_04) < thresh };
-
-                        weight01 = (useDiff) ? lookup<1792>((diff01 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight02 = (useDiff) ? lookup<1792>((diff02 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight03 = (useDiff) ? lookup<1792>((diff03 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight04 = (useDiff) ? lookup<1792>((diff04 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-
-                        weights01 = select(Vec4fb(check_v1_01), weights01 + weight01, weights01);
-                        weights02 = select(Vec4fb(check_v1_02), weights02 + weight02, weights02);
-                        weights03 = select(Vec4fb(check_v1_03), weights03 + weight03, weights03);
-                        weights04 = select(Vec4fb(check_v1_04), weights04 + weight04, weights04);
-
-                        sum01 = select(Vec4fb(check_v1_01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                        sum02 = select(Vec4fb(check_v1_02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 4])), weight02, sum02), sum02);
-                        sum03 = select(Vec4fb(check_v1_03), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight03, sum03), sum03);
-                        sum04 = select(Vec4fb(check_v1_04), mul_add(to_float(load<T>(&srcp[frameIndex][x + 12])), weight04, sum04), sum04);
+                        sum01 = select(Vec4fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                        sum02 = select(Vec4fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 4]) : t1_02), weight02, sum02), sum02);
+                        sum03 = select(Vec4fb(check_v03), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_03), weight03, sum03), sum03);
+                        sum04 = select(Vec4fb(check_v04), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 12]) : t1_04), weight04, sum04), sum04);
 
                         --frameIndex;
-                        v += 256;
+                        int v{ 256 };
+
+                        if constexpr (maxr > 1)
+                        {
+                            while (frameIndex > fromFrame)
+                            {
+                                const auto t2_01{ t1_01 };
+                                t1_01 = load<T>(&pfp[frameIndex][x]);
+                                diff01 = abs(c01 - t1_01);
+                                check_v01 = check_v01 && diff01 < thresh && abs(t1_01 - t2_01) < thresh;
+
+                                const auto t2_02{ t1_02 };
+                                t1_02 = load<T>(&pfp[frameIndex][x + 4]);
+                                diff02 = abs(c02 - t1_02);
+                                check_v02 = check_v02 && diff02 < thresh && abs(t1_02 - t2_02) < thresh;
+
+                                const auto t2_03{ t1_03 };
+                                t1_03 = load<T>(&pfp[frameIndex][x + 8]);
+                                diff03 = abs(c03 - t1_03);
+                                check_v03 = check_v03 && diff03 < thresh && abs(t1_03 - t2_03) < thresh;
+
+                                const auto t2_04{ t1_04 };
+                                t1_04 = load<T>(&pfp[frameIndex][x + 12]);
+                                diff04 = abs(c04 - t1_04);
+                                check_v04 = check_v04 && diff04 < thresh && abs(t1_04 - t2_04) < thresh;
+
+                                if (!horizontal_or(check_v01 | check_v02 | check_v03 | check_v04))
+                                    break;
+
+                                weight01 = (useDiff) ? lookup<256 * maxr>((diff01 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight02 = (useDiff) ? lookup<256 * maxr>((diff02 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight03 = (useDiff) ? lookup<256 * maxr>((diff03 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight04 = (useDiff) ? lookup<256 * maxr>((diff04 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+
+                                weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
+                                weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
+                                weights03 = select(Vec4fb(check_v03), weights03 + weight03, weights03);
+                                weights04 = select(Vec4fb(check_v04), weights04 + weight04, weights04);
+
+                                sum01 = select(Vec4fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                                sum02 = select(Vec4fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 4]) : t1_02), weight02, sum02), sum02);
+                                sum03 = select(Vec4fb(check_v03), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_03), weight03, sum03), sum03);
+                                sum04 = select(Vec4fb(check_v04), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 12]) : t1_04), weight04, sum04), sum04);
+
+                                --frameIndex;
+                                v += 256;
+                            }
+                        }
                     }
-                }
 
-                frameIndex = _maxr + 1;
+                    frameIndex = maxr + 1;
 
-                if (frameIndex < toFrame)
-                {
-                    auto t1_01{ load<T>(&pfp[frameIndex][x]) };
-                    auto diff01{ abs(c01 - t1_01) };
-                    const auto check_v01{ diff01 < thresh };
+                    if (frameIndex < toFrame)
+                    {
+                        auto t1_01{ load<T>(&pfp[frameIndex][x]) };
+                        auto diff01{ abs(c01 - t1_01) };
+                        auto check_v01{ diff01 < thresh };
 
-                    auto t1_02{ load<T>(&pfp[frameIndex][x + 4]) };
-                    auto diff02{ abs(c02 - t1_02) };
-                    const auto check_v02{ diff02 < thresh };
+                        auto t1_02{ load<T>(&pfp[frameIndex][x + 4]) };
+                        auto diff02{ abs(c02 - t1_02) };
+                        auto check_v02{ diff02 < thresh };
 
-                    auto t1_03{ load<T>(&pfp[frameIndex][x + 8]) };
-                    auto diff03{ abs(c03 - t1_03) };
-                    const auto check_v03{ diff03 < thresh };
+                        auto t1_03{ load<T>(&pfp[frameIndex][x + 8]) };
+                        auto diff03{ abs(c03 - t1_03) };
+                        auto check_v03{ diff03 < thresh };
 
-                    auto t1_04{ load<T>(&pfp[frameIndex][x + 12]) };
-                    auto diff04{ abs(c04 - t1_04) };
-                    const auto check_v04{ diff04 < thresh };
+                        auto t1_04{ load<T>(&pfp[frameIndex][x + 12]) };
+                        auto diff04{ abs(c04 - t1_04) };
+                        auto check_v04{ diff04 < thresh };
 
-                    auto weight01{ (useDiff) ? lookup<1792>(diff01 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight02{ (useDiff) ? lookup<1792>(diff02 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight03{ (useDiff) ? lookup<1792>(diff03 >> _shift, weightSaved) : weightSaved[frameIndex] };
-                    auto weight04{ (useDiff) ? lookup<1792>(diff04 >> _shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight01{ (useDiff) ? lookup<256 * maxr>(diff01 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight02{ (useDiff) ? lookup<256 * maxr>(diff02 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight03{ (useDiff) ? lookup<256 * maxr>(diff03 >> shift, weightSaved) : weightSaved[frameIndex] };
+                        auto weight04{ (useDiff) ? lookup<256 * maxr>(diff04 >> shift, weightSaved) : weightSaved[frameIndex] };
 
-                    weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
-                    weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
-                    weights03 = select(Vec4fb(check_v03), weights03 + weight03, weights03);
-                    weights04 = select(Vec4fb(check_v04), weights04 + weight04, weights04);
+                        weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
+                        weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
+                        weights03 = select(Vec4fb(check_v03), weights03 + weight03, weights03);
+                        weights04 = select(Vec4fb(check_v04), weights04 + weight04, weights04);
 
-                    sum01 = select(Vec4fb(check_v01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                    sum02 = select(Vec4fb(check_v02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 4])), weight02, sum02), sum02);
-                    sum03 = select(Vec4fb(check_v03), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight03, sum03), sum03);
-                    sum04 = select(Vec4fb(check_v04), mul_add(to_float(load<T>(&srcp[frameIndex][x + 12])), weight04, sum04), sum04);
+                        sum01 = select(Vec4fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                        sum02 = select(Vec4fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 4]) : t1_02), weight02, sum02), sum02);
+                        sum03 = select(Vec4fb(check_v03), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_03), weight03, sum03), sum03);
+                        sum04 = select(Vec4fb(check_v04), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 12]) : t1_04), weight04, sum04), sum04);
 
-                    ++frameIndex;
-                    int v{ 256 };
+                        ++frameIndex;
+                        int v{ 256 };
+
+                        if constexpr (maxr > 1)
+                        {
+                            while (frameIndex < toFrame)
+                            {
+                                const auto t2_01{ t1_01 };
+                                t1_01 = load<T>(&pfp[frameIndex][x]);
+                                diff01 = abs(c01 - t1_01);
+                                check_v01 = check_v01 && diff01 < thresh && abs(t1_01 - t2_01) < thresh;
+
+                                const auto t2_02{ t1_02 };
+                                t1_02 = load<T>(&pfp[frameIndex][x + 4]);
+                                diff02 = abs(c02 - t1_02);
+                                check_v02 = check_v02 && diff02 < thresh && abs(t1_02 - t2_02) < thresh;
+
+                                const auto t2_03{ t1_03 };
+                                t1_03 = load<T>(&pfp[frameIndex][x + 8]);
+                                diff03 = abs(c03 - t1_03);
+                                check_v03 = check_v03 && diff03 < thresh && abs(t1_03 - t2_03) < thresh;
+
+                                const auto t2_04{ t1_04 };
+                                t1_04 = load<T>(&pfp[frameIndex][x + 12]);
+                                diff04 = abs(c04 - t1_04);
+                                check_v04 = check_v04 && diff04 < thresh && abs(t1_04 - t2_04) < thresh;
+
+                                if (!horizontal_or(check_v01 | check_v02 | check_v03 | check_v04))
+                                    break;
+
+                                weight01 = (useDiff) ? lookup<256 * maxr>((diff01 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight02 = (useDiff) ? lookup<256 * maxr>((diff02 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight03 = (useDiff) ? lookup<256 * maxr>((diff03 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+                                weight04 = (useDiff) ? lookup<256 * maxr>((diff04 >> shift) + v, weightSaved) : weightSaved[frameIndex];
+
+                                weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
+                                weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
+                                weights03 = select(Vec4fb(check_v03), weights03 + weight03, weights03);
+                                weights04 = select(Vec4fb(check_v04), weights04 + weight04, weights04);
+
+                                sum01 = select(Vec4fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                                sum02 = select(Vec4fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 4]) : t1_02), weight02, sum02), sum02);
+                                sum03 = select(Vec4fb(check_v03), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 8]) : t1_03), weight03, sum03), sum03);
+                                sum04 = select(Vec4fb(check_v04), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 12]) : t1_04), weight04, sum04), sum04);
+
+                                ++frameIndex;
+                                v += 256;
+                            }
+                        }
+                    }
 
-                    while (frameIndex < toFrame)
+                    if constexpr (fp)
                     {
-                        const auto& t2_01{ t1_01 };
-                        t1_01 = load<T>(&pfp[frameIndex][x]);
-                        diff01 = abs(c01 - t1_01);
-                        const auto check_v1_01{ diff01 < thresh&& abs(t1_01 - t2_01) < thresh };
-
-                        const auto& t2_02{ t1_02 };
-                        t1_02 = load<T>(&pfp[frameIndex][x + 4]);
-                        diff02 = abs(c02 - t1_02);
-                        const auto check_v1_02{ diff02 < thresh&& abs(t1_02 - t2_02) < thresh };
-
-                        const auto& t2_03{ t1_03 };
-                        t1_03 = load<T>(&pfp[frameIndex][x + 8]);
-                        diff03 = abs(c03 - t1_03);
-                        const auto check_v1_03{ diff03 < thresh&& abs(t1_03 - t2_03) < thresh };
-
-                        const auto& t2_04{ t1_04 };
-                        t1_04 = load<T>(&pfp[frameIndex][x + 12]);
-                        diff04 = abs(c04 - t1_04);
-                        const auto check_v1_04{ diff04 < thresh&& abs(t1_04 - t2_04) < thresh };
-
-                        weight01 = (useDiff) ? lookup<1792>((diff01 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight02 = (useDiff) ? lookup<1792>((diff02 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight03 = (useDiff) ? lookup<1792>((diff03 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-                        weight04 = (useDiff) ? lookup<1792>((diff04 >> _shift) + v, weightSaved) : weightSaved[frameIndex];
-
-                        weights01 = select(Vec4fb(check_v1_01), weights01 + weight01, weights01);
-                        weights02 = select(Vec4fb(check_v1_02), weights02 + weight02, weights02);
-                        weights03 = select(Vec4fb(check_v1_03), weights03 + weight03, weights03);
-                        weights04 = select(Vec4fb(check_v1_04), weights04 + weight04, weights04);
-
-                        sum01 = select(Vec4fb(check_v1_01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                        sum02 = select(Vec4fb(check_v1_02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 4])), weight02, sum02), sum02);
-                        sum03 = select(Vec4fb(check_v1_03), mul_add(to_float(load<T>(&srcp[frameIndex][x + 8])), weight03, sum03), sum03);
-                        sum04 = select(Vec4fb(check_v1_04), mul_add(to_float(load<T>(&srcp[frameIndex][x + 12])), weight04, sum04), sum04);
-
-                        ++frameIndex;
-                        v += 256;
+                        compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x]) : c01), (1.0f - weights01), sum01 + 0.5f)), zero_si128()), zero_si128()).store_si32(dstp + x);
+                        compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x + 4]) : c02), (1.0f - weights02), sum02 + 0.5f)), zero_si128()), zero_si128()).store_si32(dstp + (x + 4));
+                        compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x + 8]) : c03), (1.0f - weights03), sum03 + 0.5f)), zero_si128()), zero_si128()).store_si32(dstp + (x + 8));
+                        compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x + 12]) : c04), (1.0f - weights04), sum04 + 0.5f)), zero_si128()), zero_si128()).store_si32(dstp + (x + 12));
+                    }
+                    else
+                    {
+                        compress_saturated_s2u(compress_saturated(truncatei(sum01 / weights01 + 0.5f), zero_si128()), zero_si128()).store_si32(dstp + x);
+                        compress_saturated_s2u(compress_saturated(truncatei(sum02 / weights02 + 0.5f), zero_si128()), zero_si128()).store_si32(dstp + (x + 4));
+                        compress_saturated_s2u(compress_saturated(truncatei(sum03 / weights03 + 0.5f), zero_si128()), zero_si128()).store_si32(dstp + (x + 8));
+                        compress_saturated_s2u(compress_saturated(truncatei(sum04 / weights04 + 0.5f), zero_si128()), zero_si128()).store_si32(dstp + (x + 12));
                     }
                 }
 
-                if constexpr (fp)
+                for (int i{ 0 }; i < diameter; ++i)
                 {
-                    compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x])), (1.0f - weights01), sum01 + 0.5f)), zero_si128()), zero_si128()).store_si32(dstp + x);
-                    compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x + 4])), (1.0f - weights02), sum02 + 0.5f)), zero_si128()), zero_si128()).store_si32(dstp + (x + 4));
-                    compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x + 8])), (1.0f - weights03), sum03 + 0.5f)), zero_si128()), zero_si128()).store_si32(dstp + (x + 8));
-                    compress_saturated_s2u(compress_saturated(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x + 12])), (1.0f - weights04), sum04 + 0.5f)), zero_si128()), zero_si128()).store_si32(dstp + (x + 12));
-                }
-                else
-                {
-                    compress_saturated_s2u(compress_saturated(truncatei(sum01 / weights01 + 0.5f), zero_si128()), zero_si128()).store_si32(dstp + x);
-                    compress_saturated_s2u(compress_saturated(truncatei(sum02 / weights02 + 0.5f), zero_si128()), zero_si128()).store_si32(dstp + (x + 4));
-                    compress_saturated_s2u(compress_saturated(truncatei(sum03 / weights03 + 0.5f), zero_si128()), zero_si128()).store_si32(dstp + (x + 8));
-                    compress_saturated_s2u(compress_saturated(truncatei(sum04 / weights04 + 0.5f), zero_si128()), zero_si128()).store_si32(dstp + (x + 12));
+                    srcp[i] += src_stride[i];
+                    pfp[i] += pf_stride[i];
                 }
+
+                dstp += stride;
             }
 
-            for (int i{ 0 }; i < _diameter; ++i)
+            for (int i{ 0 }; i < diameter; ++i)
             {
-                srcp[i] += src_stride[i];
-                pfp[i] += pf_stride[i];
+                srcp[i] -= src_stride[i] * height;
+                pfp[i] -= pf_stride[i] * height;
             }
 
-            dstp += stride;
+            dstp -= stride * height;
         }
     }
     else
     {
-        for (int y{ 0 }; y < height; ++y)
+        for (int x0{ 0 }; x0 < static_cast<int>(width); x0 += tile)
         {
-            for (int x{ 0 }; x < width; x += 8)
-            {
-                const auto& c01{ load<T>(&pfp[_maxr][x]) };
-                const auto& srcp_v01{ load<T>(&srcp[_maxr][x]) };
-
-                const auto& c02{ load<T>(&pfp[_maxr][x + 4]) };
-                const auto& srcp_v02{ load<T>(&srcp[_maxr][x + 4]) };
+            const int x1{ std::min(x0 + tile, static_cast<int>(width)) };
 
-                Vec4f weights01{ _cw };
-                auto sum01{ to_float(srcp_v01) * weights01 };
-
-                Vec4f weights02{ _cw };
-                auto sum02{ to_float(srcp_v02) * weights02 };
-
-                int frameIndex{ _maxr - 1 };
+            for (int y{ 0 }; y < height; ++y)
+            {
+                if (_tile > 0)
+                    prefetch_next_row<T, diameter, pfclip>(srcp, pfp, src_stride, pf_stride, x0, x1);
 
-                if (frameIndex > fromFrame)
+                for (int x{ x0 }; x < x1; x += 8)
                 {
-                    auto t1_01{ load<T>(&pfp[frameIndex][x]) };
-                    auto diff01{ abs(c01 - t1_01) };
-                    const auto check_v01{ diff01 < thresh };
-
-                    auto t1_02{ load<T>(&pfp[frameIndex][x + 4]) };
-                    auto diff02{ abs(c02 - t1_02) };
-                    const auto check_v02{ diff02 < thresh };
+                    const auto& c01{ load<T>(&pfp[maxr][x]) };
+                    const auto& srcp_v01{ (pfclip) ? load<T>(&srcp[maxr][x]) : c01 };
 
-                    auto weight01{ (useDiff) ? lookup<1792>(diff01 >> _shift, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved) };
-                    auto weight02{ (useDiff) ? lookup<1792>(diff02 >> _shift, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved) };
+                    const auto& c02{ load<T>(&pfp[maxr][x + 4]) };
+                    const auto& srcp_v02{ (pfclip) ? load<T>(&srcp[maxr][x + 4]) : c02 };
 
-                    weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
-                    weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
+                    Vec4f weights01{ _cw };
+                    auto sum01{ to_float(srcp_v01) * weights01 };
 
-                    sum01 = select(Vec4fb(check_v01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                    sum02 = select(Vec4fb(check_v02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 4])), weight02, sum02), sum02);
+                    Vec4f weights02{ _cw };
+                    auto sum02{ to_float(srcp_v02) * weights02 };
 
-                    --frameIndex;
-                    int v{ 256 };
+                    int frameIndex{ maxr - 1 };
 
-                    while (frameIndex > fromFrame)
+                    if (frameIndex > fromFrame)
                     {
-                        const auto& t2_01{ t1_01 };
-                        t1_01 = load<T>(&pfp[frameIndex][x]);
-                        diff01 = abs(c01 - t1_01);
-                        const auto check_v1_01{ diff01 < thresh&& abs(t1_01 - t2_01) < thresh };
+                        auto t1_01{ load<T>(&pfp[frameIndex][x]) };
+                        auto diff01{ abs(c01 - t1_01) };
+                        auto check_v01{ diff01 < thresh };
 
-                        const auto& t2_02{ t1_02 };
-                        t1_02 = load<T>(&pfp[frameIndex][x + 4]);
-                        diff02 = abs(c02 - t1_02);
-                        const auto check_v1_02{ diff02 < thresh&& abs(t1_02 - t2_02) < thresh };
+                        auto t1_02{ load<T>(&pfp[frameIndex][x + 4]) };
+                        auto diff02{ abs(c02 - t1_02) };
+                        auto check_v02{ diff02 < thresh };
 
-                        weight01 = (useDiff) ? lookup<1792>((diff01 >> _shift) + v, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved);
-                        weight02 = (useDiff) ? lookup<1792>((diff02 >> _shift) + v, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved);
+                        auto weight01{ (useDiff) ? lookup<256 * maxr>(diff01 >> shift, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved) };
+                        auto weight02{ (useDiff) ? lookup<256 * maxr>(diff02 >> shift, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved) };
 
-                        weights01 = select(Vec4fb(check_v1_01), weights01 + weight01, weights01);
-                        weights02 = select(Vec4fb(check_v1_02), weights02 + weight02, weights02);
+                        weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
+                        weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
 
-                        sum01 = select(Vec4fb(check_v1_01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                        sum02 = select(Vec4fb(check_v1_02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 4])), weight02, sum02), sum02);
+                        sum01 = select(Vec4fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                        sum02 = select(Vec4fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 4]) : t1_02), weight02, sum02), sum02);
 
                         --frameIndex;
-                        v += 256;
+                        int v{ 256 };
+
+                        if constexpr (maxr > 1)
+                        {
+                            while (frameIndex > fromFrame)
+                            {
+                                const auto t2_01{ t1_01 };
+                                t1_01 = load<T>(&pfp[frameIndex][x]);
+                                diff01 = abs(c01 - t1_01);
+                                check_v01 = check_v01 && diff01 < thresh && abs(t1_01 - t2_01) < thresh;
+
+                                const auto t2_02{ t1_02 };
+                                t1_02 = load<T>(&pfp[frameIndex][x + 4]);
+                                diff02 = abs(c02 - t1_02);
+                                check_v02 = check_v02 && diff02 < thresh && abs(t1_02 - t2_02) < thresh;
+
+                                if (!horizontal_or(check_v01 | check_v02))
+                                    break;
+
+                                weight01 = (useDiff) ? lookup<256 * maxr>((diff01 >> shift) + v, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved);
+                                weight02 = (useDiff) ? lookup<256 * maxr>((diff02 >> shift) + v, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved);
+
+                                weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
+                                weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
+
+                                sum01 = select(Vec4fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                                sum02 = select(Vec4fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 4]) : t1_02), weight02, sum02), sum02);
+
+                                --frameIndex;
+                                v += 256;
+                            }
+                        }
                     }
-                }
 
-                frameIndex = _maxr + 1;
+                    frameIndex = maxr + 1;
 
-                if (frameIndex < toFrame)
-                {
-                    auto t1_01{ load<T>(&pfp[frameIndex][x]) };
-                    auto diff01{ abs(c01 - t1_01) };
-                    const auto check_v01{ diff01 < thresh };
-
-                    auto t1_02{ load<T>(&pfp[frameIndex][x + 4]) };
-                    auto diff02{ abs(c02 - t1_02) };
-                    const auto check_v02{ diff02 < thresh };
-
-                    auto weight01{ (useDiff) ? lookup<1792>(diff01 >> _shift, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved) };
-                    auto weight02{ (useDiff) ? lookup<1792>(diff02 >> _shift, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved) };
-
-                    weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
-                    weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
-
-                    sum01 = select(Vec4fb(check_v01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                    sum02 = select(Vec4fb(check_v02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 4])), weight02, sum02), sum02);
-
-                    ++frameIndex;
-                    int v{ 256 };
-
-                    while (frameIndex < toFrame)
+                    if (frameIndex < toFrame)
                     {
-                        const auto& t2_01{ t1_01 };
-                        t1_01 = load<T>(&pfp[frameIndex][x]);
-                        diff01 = abs(c01 - t1_01);
-                        const auto check_v1_01{ diff01 < thresh&& abs(t1_01 - t2_01) < thresh };
+                        auto t1_01{ load<T>(&pfp[frameIndex][x]) };
+                        auto diff01{ abs(c01 - t1_01) };
+                        auto check_v01{ diff01 < thresh };
 
-                        const auto& t2_02{ t1_02 };
-                        t1_02 = load<T>(&pfp[frameIndex][x + 4]);
-                        diff02 = abs(c02 - t1_02);
-                        const auto check_v1_02{ diff02 < thresh&& abs(t1_02 - t2_02) < thresh };
+                        auto t1_02{ load<T>(&pfp[frameIndex][x + 4]) };
+                        auto diff02{ abs(c02 - t1_02) };
+                        auto check_v02{ diff02 < thresh };
 
-                        weight01 = (useDiff) ? lookup<1792>((diff01 >> _shift) + v, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved);
-                        weight02 = (useDiff) ? lookup<1792>((diff02 >> _shift) + v, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved);
+                        auto weight01{ (useDiff) ? lookup<256 * maxr>(diff01 >> shift, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved) };
+                        auto weight02{ (useDiff) ? lookup<256 * maxr>(diff02 >> shift, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved) };
 
-                        weights01 = select(Vec4fb(check_v1_01), weights01 + weight01, weights01);
-                        weights02 = select(Vec4fb(check_v1_02), weights02 + weight02, weights02);
+                        weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
+                        weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
 
-                        sum01 = select(Vec4fb(check_v1_01), mul_add(to_float(load<T>(&srcp[frameIndex][x])), weight01, sum01), sum01);
-                        sum02 = select(Vec4fb(check_v1_02), mul_add(to_float(load<T>(&srcp[frameIndex][x + 4])), weight02, sum02), sum02);
+                        sum01 = select(Vec4fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                        sum02 = select(Vec4fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 4]) : t1_02), weight02, sum02), sum02);
 
                         ++frameIndex;
-                        v += 256;
+                        int v{ 256 };
+
+                        if constexpr (maxr > 1)
+                        {
+                            while (frameIndex < toFrame)
+                            {
+                                const auto t2_01{ t1_01 };
+                                t1_01 = load<T>(&pfp[frameIndex][x]);
+                                diff01 = abs(c01 - t1_01);
+                                check_v01 = check_v01 && diff01 < thresh && abs(t1_01 - t2_01) < thresh;
+
+                                const auto t2_02{ t1_02 };
+                                t1_02 = load<T>(&pfp[frameIndex][x + 4]);
+                                diff02 = abs(c02 - t1_02);
+                                check_v02 = check_v02 && diff02 < thresh && abs(t1_02 - t2_02) < thresh;
+
+                                if (!horizontal_or(check_v01 | check_v02))
+                                    break;
+
+                                weight01 = (useDiff) ? lookup<256 * maxr>((diff01 >> shift) + v, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved);
+                                weight02 = (useDiff) ? lookup<256 * maxr>((diff02 >> shift) + v, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved);
+
+                                weights01 = select(Vec4fb(check_v01), weights01 + weight01, weights01);
+                                weights02 = select(Vec4fb(check_v02), weights02 + weight02, weights02);
+
+                                sum01 = select(Vec4fb(check_v01), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x]) : t1_01), weight01, sum01), sum01);
+                                sum02 = select(Vec4fb(check_v02), mul_add(to_float((pfclip) ? load<T>(&srcp[frameIndex][x + 4]) : t1_02), weight02, sum02), sum02);
+
+                                ++frameIndex;
+                                v += 256;
+                            }
+                        }
                     }
-                }
 
-                if constexpr (fp)
-                {
-                    compress_saturated_s2u(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x])), (1.0f - weights01), sum01 + 0.5f)), zero_si128()).storel(dstp + x);
-                    compress_saturated_s2u(truncatei(mul_add(to_float(load<T>(&srcp[_maxr][x + 4])), (1.0f - weights02), sum02 + 0.5f)), zero_si128()).storel(dstp + (x + 4));
+                    if constexpr (fp)
+                    {
+                        compress_saturated_s2u(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x]) : c01), (1.0f - weights01), sum01 + 0.5f)), zero_si128()).storel(dstp + x);
+                        compress_saturated_s2u(truncatei(mul_add(to_float((pfclip) ? load<T>(&srcp[maxr][x + 4]) : c02), (1.0f - weights02), sum02 + 0.5f)), zero_si128()).storel(dstp + (x + 4));
+                    }
+                    else
+                    {
+                        compress_saturated_s2u(truncatei(sum01 / weights01 + 0.5f), zero_si128()).storel(dstp + x);
+                        compress_saturated_s2u(truncatei(sum02 / weights02 + 0.5f), zero_si128()).storel(dstp + (x + 4));
+                    }
                 }
-                else
+
+                for (int i{ 0 }; i < diameter; ++i)
                 {
-                    compress_saturated_s2u(truncatei(sum01 / weights01 + 0.5f), zero_si128()).storel(dstp + x);
-                    compress_saturated_s2u(truncatei(sum02 / weights02 + 0.5f), zero_si128()).storel(dstp + (x + 4));
+                    srcp[i] += src_stride[i];
+                    pfp[i] += pf_stride[i];
                 }
+
+                dstp += stride;
             }
 
-            for (int i{ 0 }; i < _diameter; ++i)
+            for (int i{ 0 }; i < diameter; ++i)
             {
-                srcp[i] += src_stride[i];
-                pfp[i] += pf_stride[i];
+                srcp[i] -= src_stride[i] * height;
+                pfp[i] -= pf_stride[i] * height;
             }
 
-            dstp += stride;
+            dstp -= stride * height;
         }
     }
 }
 
-template void TTempSmooth<true, true>::filterI_sse2<uint8_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterI_sse2<uint8_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, true>::filterI_sse2<uint8_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterI_sse2<uint8_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-
-template void TTempSmooth<false, true>::filterI_sse2<uint8_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterI_sse2<uint8_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, true>::filterI_sse2<uint8_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterI_sse2<uint8_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-
-template void TTempSmooth<true, true>::filterI_sse2<uint16_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterI_sse2<uint16_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, true>::filterI_sse2<uint16_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterI_sse2<uint16_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-
-template void TTempSmooth<false, true>::filterI_sse2<uint16_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterI_sse2<uint16_t, true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, true>::filterI_sse2<uint16_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterI_sse2<uint16_t, false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-
 template <bool pfclip, bool fp>
-template <bool useDiff>
-void TTempSmooth<pfclip, fp>::filterF_sse2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept
+template <bool useDiff, int maxr>
+void TTempSmooth<pfclip, fp>::filterF_sse2(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const int y0, const int y1, uint32_t* guide) noexcept
 {
-    int src_stride[15]{};
-    int pf_stride[15]{};
+    constexpr int diameter{ maxr * 2 + 1 };
+    int src_stride[diameter]{};
+    int pf_stride[diameter]{};
     const int stride{ dst->GetPitch(plane) / 4 };
     const int width{ dst->GetRowSize(plane) / 4 };
-    const int height{ dst->GetHeight(plane) };
-    const float* srcp[15]{}, * pfp[15]{};
-    for (int i{ 0 }; i < _diameter; ++i)
+    const int height{ y1 - y0 };
+    const float* srcp[diameter]{}, * pfp[diameter]{};
+    for (int i{ 0 }; i < diameter; ++i)
     {
         src_stride[i] = src[i]->GetPitch(plane) / 4;
         pf_stride[i] = pf[i]->GetPitch(plane) / 4;
-        srcp[i] = reinterpret_cast<const float*>(src[i]->GetReadPtr(plane));
-        pfp[i] = reinterpret_cast<const float*>(pf[i]->GetReadPtr(plane));
+        srcp[i] = reinterpret_cast<const float*>(src[i]->GetReadPtr(plane)) + y0 * src_stride[i];
+        pfp[i] = reinterpret_cast<const float*>(pf[i]->GetReadPtr(plane)) + y0 * pf_stride[i];
     }
 
-    float* __restrict dstp{ reinterpret_cast<float*>(dst->GetWritePtr(plane)) };
+    float* __restrict dstp{ reinterpret_cast<float*>(dst->GetWritePtr(plane)) + y0 * stride };
 
     const int l{ plane >> 1 };
     const float* const weightSaved{ _weight[l].data() };
     const Vec4f thresh{ _threshF[l] };
+    const int tile{ (_tile > 0) ? _tile : width };
+    const bool nt{ _tile > 0 && !(reinterpret_cast<uintptr_t>(dstp) & 63) && !((stride * 4) & 63) };
 
-    for (int y{ 0 }; y < height; ++y)
+    for (int x0{ 0 }; x0 < static_cast<int>(width); x0 += tile)
     {
-        for (int x{ 0 }; x < width; x += 4)
-        {
-            const auto& c{ Vec4f().load(&pfp[_maxr][x]) };
-            const auto& srcp_v{ Vec4f().load(&srcp[_maxr][x]) };
-
-            Vec4f weights{ _cw };
-            auto sum{ srcp_v * weights };
+        const int x1{ std::min(x0 + tile, width) };
 
-            int frameIndex{ _maxr - 1 };
+        for (int y{ 0 }; y < height; ++y)
+        {
+            if (_tile > 0)
+                prefetch_next_row<float, diameter, pfclip>(srcp, pfp, src_stride, pf_stride, x0, x1);
 
-            if (frameIndex > fromFrame)
+            for (int x{ x0 }; x < x1; x += 4)
             {
-                auto t1{ Vec4f().load(&pfp[frameIndex][x]) };
-                auto diff{ min(abs(c - t1), 1.0f) };
-                const auto check_v{ diff < thresh };
+                const auto c{ Vec4f().load(&pfp[maxr][x]) };
+                const auto srcp_v{ (pfclip) ? Vec4f().load(&srcp[maxr][x]) : c };
 
-                auto weight{ (useDiff) ? lookup<1792>(truncatei(diff * 255.0f), weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved) };
-                weights = select(check_v, weights + weight, weights);
-                sum = select(check_v, mul_add(Vec4f().load(&srcp[frameIndex][x]), weight, sum), sum);
+                Vec4f weights{ _cw };
+                auto sum{ srcp_v * weights };
 
-                --frameIndex;
-                int v{ 256 };
+                int frameIndex{ maxr - 1 };
 
-                while (frameIndex > fromFrame)
+                if (frameIndex > fromFrame)
                 {
-                    const auto& t2{ t1 };
-                    t1 = Vec4f().load(&pfp[frameIndex][x]);
-                    diff = min(abs(c - t1), 1.0f);
-                    const auto check_v1{ diff < thresh&& min(abs(t1 - t2), 1.0f) < thresh };
+                    auto t1{ Vec4f().load(&pfp[frameIndex][x]) };
+                    auto diff{ min(abs(c - t1), 1.0f) };
+                    auto check_v{ diff < thresh };
 
-                    weight = (useDiff) ? lookup<1792>(truncatei(diff * 255.0f) + v, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved);
-                    weights = select(check_v1, weights + weight, weights);
-                    sum = select(check_v1, mul_add(Vec4f().load(&srcp[frameIndex][x]), weight, sum), sum);
+                    auto weight{ (useDiff) ? lookup<256 * maxr>(truncatei(diff * 255.0f), weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved) };
+                    weights = select(check_v, weights + weight, weights);
+                    sum = select(check_v, mul_add((pfclip) ? Vec4f().load(&srcp[frameIndex][x]) : t1, weight, sum), sum);
 
                     --frameIndex;
-                    v += 256;
-                }
-            }
-
-            frameIndex = _maxr + 1;
-
-            if (frameIndex < toFrame)
-            {
-                auto t1{ Vec4f().load(&pfp[frameIndex][x]) };
-                auto diff{ min(abs(c - t1), 1.0f) };
-                const auto check_v{ diff < thresh };
+                    int v{ 256 };
 
-                auto weight{ (useDiff) ? lookup<1792>(truncatei(diff * 255.0f), weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved) };
-                weights = select(check_v, weights + weight, weights);
-                sum = select(check_v, mul_add(Vec4f().load(&srcp[frameIndex][x]), weight, sum), sum);
+                    if constexpr (maxr > 1)
+                    {
+                        while (frameIndex > fromFrame)
+                        {
+                            const auto t2{ t1 };
+                            t1 = Vec4f().load(&pfp[frameIndex][x]);
+                            diff = min(abs(c - t1), 1.0f);
+                            check_v = check_v && diff < thresh && min(abs(t1 - t2), 1.0f) < thresh;
+
+                            if (!horizontal_or(check_v))
+                                break;
+
+                            weight = (useDiff) ? lookup<256 * maxr>(truncatei(diff * 255.0f) + v, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved);
+                            weights = select(check_v, weights + weight, weights);
+                            sum = select(check_v, mul_add((pfclip) ? Vec4f().load(&srcp[frameIndex][x]) : t1, weight, sum), sum);
+
+                            --frameIndex;
+                            v += 256;
+                        }
+                    }
+                }
 
-                ++frameIndex;
-                int v{ 256 };
+                frameIndex = maxr + 1;
 
-                while (frameIndex < toFrame)
+                if (frameIndex < toFrame)
                 {
-                    const auto& t2{ t1 };
-                    t1 = Vec4f().load(&pfp[frameIndex][x]);
-                    diff = min(abs(c - t1), 1.0f);
-                    const auto check_v1{ diff < thresh&& min(abs(t1 - t2), 1.0f) < thresh };
+                    auto t1{ Vec4f().load(&pfp[frameIndex][x]) };
+                    auto diff{ min(abs(c - t1), 1.0f) };
+                    auto check_v{ diff < thresh };
 
-                    weight = (useDiff) ? lookup<1792>(truncatei(diff * 255.0f) + v, weightSaved) : lookup<1792>(Vec4i(frameIndex), weightSaved);
-                    weights = select(check_v1, weights + weight, weights);
-                    sum = select(check_v1, mul_add(Vec4f().load(&srcp[frameIndex][x]), weight, sum), sum);
+                    auto weight{ (useDiff) ? lookup<256 * maxr>(truncatei(diff * 255.0f), weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved) };
+                    weights = select(check_v, weights + weight, weights);
+                    sum = select(check_v, mul_add((pfclip) ? Vec4f().load(&srcp[frameIndex][x]) : t1, weight, sum), sum);
 
                     ++frameIndex;
-                    v += 256;
+                    int v{ 256 };
+
+                    if constexpr (maxr > 1)
+                    {
+                        while (frameIndex < toFrame)
+                        {
+                            const auto t2{ t1 };
+                            t1 = Vec4f().load(&pfp[frameIndex][x]);
+                            diff = min(abs(c - t1), 1.0f);
+                            check_v = check_v && diff < thresh && min(abs(t1 - t2), 1.0f) < thresh;
+
+                            if (!horizontal_or(check_v))
+                                break;
+
+                            weight = (useDiff) ? lookup<256 * maxr>(truncatei(diff * 255.0f) + v, weightSaved) : lookup<256 * maxr>(Vec4i(frameIndex), weightSaved);
+                            weights = select(check_v, weights + weight, weights);
+                            sum = select(check_v, mul_add((pfclip) ? Vec4f().load(&srcp[frameIndex][x]) : t1, weight, sum), sum);
+
+                            ++frameIndex;
+                            v += 256;
+                        }
+                    }
                 }
+
+                if constexpr (fp)
+                    store(mul_add((pfclip) ? Vec4f().load(&srcp[maxr][x]) : c, (1.0f - weights), sum), dstp + x, nt);
+                else
+                    store(sum / weights, dstp + x, nt);
             }
 
-            if constexpr (fp)
-                mul_add(Vec4f().load(&srcp[_maxr][x]), (1.0f - weights), sum).store(dstp + x);
-            else
-                (sum / weights).store(dstp + x);
+            for (int i{ 0 }; i < diameter; ++i)
+            {
+                srcp[i] += src_stride[i];
+                pfp[i] += pf_stride[i];
+            }
+
+            dstp += stride;
         }
 
-        for (int i{ 0 }; i < _diameter; ++i)
+        for (int i{ 0 }; i < diameter; ++i)
         {
-            srcp[i] += src_stride[i];
-            pfp[i] += pf_stride[i];
+            srcp[i] -= src_stride[i] * height;
+            pfp[i] -= pf_stride[i] * height;
         }
 
-        dstp += stride;
+        dstp -= stride * height;
+    }
+
+    if (nt)
+        _mm_sfence();
+}
+
+template <bool pfclip, bool fp>
+template <typename T, bool useDiff>
+typename TTempSmooth<pfclip, fp>::filter_t TTempSmooth<pfclip, fp>::get_filter_sse2() const noexcept
+{
+    if constexpr (std::is_same_v<T, float>)
+    {
+        switch (_maxr)
+        {
+            case 1: return &TTempSmooth::filterF_sse2<useDiff, 1>;
+            case 2: return &TTempSmooth::filterF_sse2<useDiff, 2>;
+            case 3: return &TTempSmooth::filterF_sse2<useDiff, 3>;
+            case 4: return &TTempSmooth::filterF_sse2<useDiff, 4>;
+            case 5: return &TTempSmooth::filterF_sse2<useDiff, 5>;
+            case 6: return &TTempSmooth::filterF_sse2<useDiff, 6>;
+            default: return &TTempSmooth::filterF_sse2<useDiff, 7>;
+        }
+    }
+    else
+    {
+        switch (_maxr)
+        {
+            case 1: return &TTempSmooth::filterI_sse2<T, useDiff, 1>;
+            case 2: return &TTempSmooth::filterI_sse2<T, useDiff, 2>;
+            case 3: return &TTempSmooth::filterI_sse2<T, useDiff, 3>;
+            case 4: return &TTempSmooth::filterI_sse2<T, useDiff, 4>;
+            case 5: return &TTempSmooth::filterI_sse2<T, useDiff, 5>;
+            case 6: return &TTempSmooth::filterI_sse2<T, useDiff, 6>;
+            default: return &TTempSmooth::filterI_sse2<T, useDiff, 7>;
+        }
     }
 }
 
-template void TTempSmooth<true, true>::filterF_sse2<true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterF_sse2<true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, true>::filterF_sse2<false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<true, false>::filterF_sse2<false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_sse2<uint8_t, true>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_sse2<uint8_t, true>() const noexcept;
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_sse2<uint8_t, false>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_sse2<uint8_t, false>() const noexcept;
 
-template void TTempSmooth<false, true>::filterF_sse2<true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterF_sse2<true>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, true>::filterF_sse2<false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
-template void TTempSmooth<false, false>::filterF_sse2<false>(PVideoFrame src[15], PVideoFrame pf[15], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane) noexcept;
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_sse2<uint8_t, true>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_sse2<uint8_t, true>() const noexcept;
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_sse2<uint8_t, false>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_sse2<uint8_t, false>() const noexcept;
+
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_sse2<uint16_t, true>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_sse2<uint16_t, true>() const noexcept;
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_sse2<uint16_t, false>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_sse2<uint16_t, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_sse2<uint16_t, true>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_sse2<uint16_t, true>() const noexcept;
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_sse2<uint16_t, false>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_sse2<uint16_t, false>() const noexcept;
+
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_sse2<float, true>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_sse2<float, true>() const noexcept;
+template TTempSmooth<true, true>::filter_t TTempSmooth<true, true>::get_filter_sse2<float, false>() const noexcept;
+template TTempSmooth<true, false>::filter_t TTempSmooth<true, false>::get_filter_sse2<float, false>() const noexcept;
+
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_sse2<float, true>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_sse2<float, true>() const noexcept;
+template TTempSmooth<false, true>::filter_t TTempSmooth<false, true>::get_filter_sse2<float, false>() const noexcept;
+template TTempSmooth<false, false>::filter_t TTempSmooth<false, false>::get_filter_sse2<float, false>() const noexcept;
 
 template <typename T>
-float ComparePlane_sse2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept
+float ComparePlane_sse2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept
 {
     const size_t pitch{ src->GetPitch(PLANAR_Y) / sizeof(T) };
     const size_t pitch2{ src1->GetPitch(PLANAR_Y) / sizeof(T) };
@@ -542,28 +676,70 @@ float ComparePlane_sse2(PVideoFrame& src, PVideoFrame& src1, const int bits_per_
     const T* srcp{ reinterpret_cast<const T*>(src->GetReadPtr(PLANAR_Y)) };
     const T* srcp2{ reinterpret_cast<const T*>(src1->GetReadPtr(PLANAR_Y)) };
 
-    Vec4f accum{ 0.0f };
-
-    for (size_t y{ 0 }; y < height; ++y)
+    if constexpr (std::is_integral_v<T>)
     {
-        for (size_t x{ 0 }; x < width; x += 4)
+        // exact integer SAD; stops once the result is known to be above limit
+        const double norm{ static_cast<double>((1 << bits_per_pixel) - 1) * height * width };
+        const uint64_t sad_limit{ static_cast<uint64_t>(limit * norm) };
+        const size_t vec_width{ width & ~static_cast<size_t>(16 / sizeof(T) - 1) };
+        uint64_t sad{ 0 };
+
+        for (int y{ 0 }; y < height && sad <= sad_limit; ++y)
         {
-            if constexpr (std::is_integral_v<T>)
-                accum += abs(to_float(load<T>(&srcp[x])) - to_float(load<T>(&srcp2[x])));
+            if constexpr (std::is_same_v<T, uint8_t>)
+            {
+                Vec2uq accum{ 0 };
+
+                for (size_t x{ 0 }; x < vec_width; x += 16)
+                    accum += Vec2uq(_mm_sad_epu8(Vec16uc().load(&srcp[x]), Vec16uc().load(&srcp2[x])));
+
+                sad += horizontal_add(accum);
+            }
             else
-                accum += abs(Vec4f().load(&srcp[x]) - Vec4f().load(&srcp2[x]));
+            {
+                Vec4ui accum{ 0 };
+
+                for (size_t x{ 0 }; x < vec_width; x += 8)
+                {
+                    const Vec8us a{ Vec8us().load(&srcp[x]) };
+                    const Vec8us b{ Vec8us().load(&srcp2[x]) };
+                    const Vec8us diff{ sub_saturated(a, b) | sub_saturated(b, a) };
+                    accum += extend_low(diff) + extend_high(diff);
+                }
+
+                sad += horizontal_add_x(accum);
+            }
+
+            for (size_t x{ vec_width }; x < width; ++x)
+                sad += std::abs(srcp[x] - srcp2[x]);
+
+            srcp += pitch;
+            srcp2 += pitch2;
         }
 
-        srcp += pitch;
-        srcp2 += pitch2;
+        return static_cast<float>(sad / norm);
     }
-
-    if constexpr (std::is_integral_v<T>)
-        return horizontal_add(accum / ((1 << bits_per_pixel) - 1)) / (height * width);
     else
+    {
+        const float accum_limit{ limit * height * width };
+        Vec4f accum{ 0.0f };
+
+        for (int y{ 0 }; y < height; ++y)
+        {
+            for (size_t x{ 0 }; x < width; x += 4)
+                accum += abs(Vec4f().load(&srcp[x]) - Vec4f().load(&srcp2[x]));
+
+            srcp += pitch;
+            srcp2 += pitch2;
+
+            if (horizontal_add(accum) > accum_limit)
+                break;
+        }
+
         return horizontal_add(accum) / (height * width);
+    }
 }
 
-template float ComparePlane_sse2<uint8_t>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
-template float ComparePlane_sse2<uint16_t>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
-template float ComparePlane_sse2<float>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel) noexcept;
+template float ComparePlane_sse2<uint8_t>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
+template float ComparePlane_sse2<uint16_t>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
+template float ComparePlane_sse2<float>(PVideoFrame& src, PVideoFrame& src1, const int bits_per_pixel, const float limit) noexcept;
@@ -59,7 +59,7 @@ ymm_out16_2 = _mm256_permute4x64_epi64(ymm_out16_2, 0xD8);
 
 template<bool pfclip, bool fp>
 template<typename T>
-void TTempSmooth<pfclip, fp>::filterI_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane)
+void TTempSmooth<pfclip, fp>::filterI_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win)
 {
     int src_stride[(MAX_TEMP_RAD * 2 + 1)]{};
     int pf_stride[(MAX_TEMP_RAD * 2 + 1)]{};
@@ -109,12 +109,16 @@ void TTempSmooth<pfclip, fp>::filterI_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
     const __m256i ymm_idx_add_h8_1 = _mm256_set_epi32(23, 22, 21, 20, 19, 18, 17, 16);
     const __m256i ymm_idx_add_h8_2 = _mm256_set_epi32(31, 30, 29, 28, 27, 26, 25, 24);
 
-#pragma omp parallel for num_threads(_threads)
+    const bool touch{ !_iir_touched[l] && thUPD > 0 };
+    _iir_touched[l] = true;
+
+    const thread_budget budget(_threads);
+
+#pragma omp parallel for num_threads(budget.threads())
     for (int y = 0; y < height; ++y)
     {
-        // local threads temp
-        alignas(32) __m256i Temp256[(MAX_TEMP_RAD * 2 + 1) * 4];
-        __m256i* pTemp256 = &Temp256[0];
+        // local threads temp, sized to the window
+        __m256i* pTemp256 = static_cast<__m256i*>(thread_scratch(_diameter * 4 * sizeof(__m256i)));
 
         // local threads ptrs
         const T* srcp[(MAX_TEMP_RAD * 2 + 1)]{}, * pfp[(MAX_TEMP_RAD * 2 + 1)]{};
@@ -131,11 +135,18 @@ void TTempSmooth<pfclip, fp>::filterI_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
         pMem = g_pMem + y * width;
         pMemSum = g_pMemSum + y * width;
 
+        if (touch)
+        {
+            std::fill_n(pMem, width, 0);
+            std::fill_n(pMemSum, width, std::numeric_limits<int>::max());
+        }
+
         for (int x{ 0 }; x < width; x += 32)
         {
             // copy all input frames processed samples in SIMD pass in the temp buf in uint32 form
-            for (int i = 0; i < (_maxr * 2 + 1); i++)
+            for (int ws = 0; ws < win.num; ws++)
             {
+                const int i = win.slot[ws];
                 T* data_ptr;
                 if (i == _maxr) // src sample
                 {
@@ -190,15 +201,17 @@ void TTempSmooth<pfclip, fp>::filterI_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
             __m256i ymm_idx_minrow_h8_2 = _mm256_setzero_si256();
 
 
-            for (int dmt_row = 0; dmt_row < (_maxr * 2 + 1); dmt_row++)
+            for (int wr = 0; wr < win.num; wr++)
             {
+                const int dmt_row = win.slot[wr];
                 __m256i ymm_sum_row_l8_1 = _mm256_setzero_si256();
                 __m256i ymm_sum_row_l8_2 = _mm256_setzero_si256();
                 __m256i ymm_sum_row_h8_1 = _mm256_setzero_si256();
                 __m256i ymm_sum_row_h8_2 = _mm256_setzero_si256();
 
-                for (int dmt_col = 0; dmt_col < (_maxr * 2 + 1); dmt_col++)
+                for (int wc = 0; wc < win.num; wc++)
                 {
+                    const int dmt_col = win.slot[wc];
                     if (dmt_row == dmt_col)
                     { // samples with itselves => DM=0
                         continue;
@@ -226,6 +239,16 @@ void TTempSmooth<pfclip, fp>::filterI_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
                     __m256i ymm_abs_h8_1 = _mm256_abs_epi32(ymm_subtr_h8_1);
                     __m256i ymm_abs_h8_2 = _mm256_abs_epi32(ymm_subtr_h8_2);
 
+                    // copies of a clamped edge frame
+                    if (win.mult[wc] > 1)
+                    {
+                        const __m256i ymm_mult = _mm256_set1_epi32(win.mult[wc]);
+                        ymm_abs_l8_1 = _mm256_mullo_epi32(ymm_abs_l8_1, ymm_mult);
+                        ymm_abs_l8_2 = _mm256_mullo_epi32(ymm_abs_l8_2, ymm_mult);
+                        ymm_abs_h8_1 = _mm256_mullo_epi32(ymm_abs_h8_1, ymm_mult);
+                        ymm_abs_h8_2 = _mm256_mullo_epi32(ymm_abs_h8_2, ymm_mult);
+                    }
+
                     ymm_sum_row_l8_1 = _mm256_add_epi32(ymm_sum_row_l8_1, ymm_abs_l8_1);
                     ymm_sum_row_l8_2 = _mm256_add_epi32(ymm_sum_row_l8_2, ymm_abs_l8_2);
                     ymm_sum_row_h8_1 = _mm256_add_epi32(ymm_sum_row_h8_1, ymm_abs_h8_1);
@@ -441,19 +464,19 @@ void TTempSmooth<pfclip, fp>::filterI_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
 
 }
 
-template void TTempSmooth<true, true>::filterI_mode2_avx2<uint8_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<true, false>::filterI_mode2_avx2<uint8_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<false, true>::filterI_mode2_avx2<uint8_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<false, false>::filterI_mode2_avx2<uint8_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<true, true>::filterI_mode2_avx2<uint8_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<true, false>::filterI_mode2_avx2<uint8_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<false, true>::filterI_mode2_avx2<uint8_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<false, false>::filterI_mode2_avx2<uint8_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
 
-template void TTempSmooth<true, true>::filterI_mode2_avx2<uint16_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<true, false>::filterI_mode2_avx2<uint16_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<false, true>::filterI_mode2_avx2<uint16_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<false, false>::filterI_mode2_avx2<uint16_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<true, true>::filterI_mode2_avx2<uint16_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<true, false>::filterI_mode2_avx2<uint16_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<false, true>::filterI_mode2_avx2<uint16_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<false, false>::filterI_mode2_avx2<uint16_t>(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
 
 
 template<bool pfclip, bool fp>
-void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane)
+void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win)
 {
     int src_stride[(MAX_TEMP_RAD * 2 + 1)]{};
     int pf_stride[(MAX_TEMP_RAD * 2 + 1)]{};
@@ -490,12 +513,16 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
     const __m256i ymm_idx_add_h8_1 = _mm256_set_epi32(23, 22, 21, 20, 19, 18, 17, 16);
     const __m256i ymm_idx_add_h8_2 = _mm256_set_epi32(31, 30, 29, 28, 27, 26, 25, 24);
 
-#pragma omp parallel for num_threads(_threads)
+    const bool touch{ !_iir_touched[l] && thUPD > 0 };
+    _iir_touched[l] = true;
+
+    const thread_budget budget(_threads);
+
+#pragma omp parallel for num_threads(budget.threads())
     for (int y = 0; y < height; ++y)
     {
-        // local threads temp
-        alignas(32) __m256 Temp256[(MAX_TEMP_RAD * 2 + 1) * 4];
-        __m256* pTemp256 = &Temp256[0];
+        // local threads temp, sized to the window
+        __m256* pTemp256 = static_cast<__m256*>(thread_scratch(_diameter * 4 * sizeof(__m256)));
 
         // local threads ptrs
         const float* srcp[(MAX_TEMP_RAD * 2 + 1)]{}, * pfp[(MAX_TEMP_RAD * 2 + 1)]{};
@@ -512,13 +539,20 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
         pMem = g_pMem + y * width;
         pMemSum = g_pMemSum + y * width;
 
+        if (touch)
+        {
+            std::fill_n(pMem, width, 0);
+            std::fill_n(pMemSum, width, std::numeric_limits<float>::max());
+        }
+
         const int col32 = width - (width % SIMD_AVX2_SPP);
 
         for (int x{ 0 }; x < col32; x += SIMD_AVX2_SPP)
         {
             // copy all input frames processed samples in SIMD pass in the temp buf in float32 form
-            for (int i = 0; i < (_maxr * 2 + 1); i++)
+            for (int ws = 0; ws < win.num; ws++)
             {
+                const int i = win.slot[ws];
                 float* data_ptr;
                 if (i == _maxr) // src sample
                 {
@@ -558,15 +592,17 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
             __m256i ymm_idx_minrow_h8_2 = _mm256_setzero_si256();
 
 
-            for (int dmt_row = 0; dmt_row < (_maxr * 2 + 1); dmt_row++)
+            for (int wr = 0; wr < win.num; wr++)
             {
+                const int dmt_row = win.slot[wr];
                 __m256 ymm_sum_row_l8_1 = _mm256_setzero_ps();
                 __m256 ymm_sum_row_l8_2 = _mm256_setzero_ps();
                 __m256 ymm_sum_row_h8_1 = _mm256_setzero_ps();
                 __m256 ymm_sum_row_h8_2 = _mm256_setzero_ps();
 
-                for (int dmt_col = 0; dmt_col < (_maxr * 2 + 1); dmt_col++)
+                for (int wc = 0; wc < win.num; wc++)
                 {
+                    const int dmt_col = win.slot[wc];
                     if (dmt_row == dmt_col)
                     { // samples with itselves => DM=0
                         continue;
@@ -594,6 +630,16 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
                     __m256 ymm_abs_h8_1 = _mm256_andnot_ps(sign_bit, ymm_subtr_h8_1);
                     __m256 ymm_abs_h8_2 = _mm256_andnot_ps(sign_bit, ymm_subtr_h8_2);
 
+                    // copies of a clamped edge frame
+                    if (win.mult[wc] > 1)
+                    {
+                        const __m256 ymm_mult = _mm256_set1_ps(static_cast<float>(win.mult[wc]));
+                        ymm_abs_l8_1 = _mm256_mul_ps(ymm_abs_l8_1, ymm_mult);
+                        ymm_abs_l8_2 = _mm256_mul_ps(ymm_abs_l8_2, ymm_mult);
+                        ymm_abs_h8_1 = _mm256_mul_ps(ymm_abs_h8_1, ymm_mult);
+                        ymm_abs_h8_2 = _mm256_mul_ps(ymm_abs_h8_2, ymm_mult);
+                    }
+
                     ymm_sum_row_l8_1 = _mm256_add_ps(ymm_sum_row_l8_1, ymm_abs_l8_1);
                     ymm_sum_row_l8_2 = _mm256_add_ps(ymm_sum_row_l8_2, ymm_abs_l8_2);
                     ymm_sum_row_h8_1 = _mm256_add_ps(ymm_sum_row_h8_1, ymm_abs_h8_1);
@@ -765,8 +811,9 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
         for (int x{ col32 }; x < width; x += 16)
         {
             // copy all input frames processed samples in SIMD pass in the temp buf in float32 form
-            for (int i = 0; i < (_maxr * 2 + 1); i++)
+            for (int ws = 0; ws < win.num; ws++)
             {
+                const int i = win.slot[ws];
                 float* data_ptr;
                 if (i == _maxr) // src sample
                 {
@@ -797,13 +844,15 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
             __m256i ymm_idx_minrow_l8_2 = _mm256_setzero_si256();
 
 
-            for (int dmt_row = 0; dmt_row < (_maxr * 2 + 1); dmt_row++)
+            for (int wr = 0; wr < win.num; wr++)
             {
+                const int dmt_row = win.slot[wr];
                 __m256 ymm_sum_row_l8_1 = _mm256_setzero_ps();
                 __m256 ymm_sum_row_l8_2 = _mm256_setzero_ps();
 
-                for (int dmt_col = 0; dmt_col < (_maxr * 2 + 1); dmt_col++)
+                for (int wc = 0; wc < win.num; wc++)
                 {
+                    const int dmt_col = win.slot[wc];
                     if (dmt_row == dmt_col)
                     { // samples with itselves => DM=0
                         continue;
@@ -823,6 +872,14 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
                     __m256 ymm_abs_l8_1 = _mm256_andnot_ps(sign_bit, ymm_subtr_l8_1);
                     __m256 ymm_abs_l8_2 = _mm256_andnot_ps(sign_bit, ymm_subtr_l8_2);
 
+                    // copies of a clamped edge frame
+                    if (win.mult[wc] > 1)
+                    {
+                        const __m256 ymm_mult = _mm256_set1_ps(static_cast<float>(win.mult[wc]));
+                        ymm_abs_l8_1 = _mm256_mul_ps(ymm_abs_l8_1, ymm_mult);
+                        ymm_abs_l8_2 = _mm256_mul_ps(ymm_abs_l8_2, ymm_mult);
+                    }
+
                     ymm_sum_row_l8_1 = _mm256_add_ps(ymm_sum_row_l8_1, ymm_abs_l8_1);
                     ymm_sum_row_l8_2 = _mm256_add_ps(ymm_sum_row_l8_2, ymm_abs_l8_2);
 
@@ -949,7 +1006,7 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD *
 
 }
 
-template void TTempSmooth<true, true>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<true, false>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<false, true>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<false, false>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<true, true>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<true, false>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<false, true>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<false, false>::filterF_mode2_avx2(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
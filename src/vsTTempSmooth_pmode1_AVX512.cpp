@@ -436,7 +436,7 @@ template void TTempSmooth<false, false>::filterI_mode2_avx2<uint16_t>(PVideoFram
 #endif
 
 template<bool pfclip, bool fp>
-void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane)
+void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win)
 {
     int src_stride[(MAX_TEMP_RAD * 2 + 1)]{};
     int pf_stride[(MAX_TEMP_RAD * 2 + 1)]{};
@@ -477,15 +477,17 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD
     const __m512i zmm_idx_add_h16_1 = _mm512_set_epi32(47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33, 32);
     const __m512i zmm_idx_add_h16_2 = _mm512_set_epi32(63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49, 48);
 
-#pragma omp parallel for num_threads(_threads)
+    const bool touch{ !_iir_touched[l] && thUPD > 0 };
+    _iir_touched[l] = true;
+
+    const thread_budget budget(_threads);
+
+#pragma omp parallel for num_threads(budget.threads())
     for (int y = 0; y < height; ++y)
     {
-        // local thread temps
-        alignas(64) __m512 Temp512[(MAX_TEMP_RAD * 2 + 1) * 4];
-        __m512* pTemp512 = &Temp512[0];
-
-        alignas(32) __m256 Temp256[(MAX_TEMP_RAD * 2 + 1) * 2];
-        __m256* pTemp256 = &Temp256[0];
+        // local thread temps, sized to the window; the 256-bit part for the last columns follows the 512-bit part
+        __m512* pTemp512 = static_cast<__m512*>(thread_scratch(_diameter * (4 * sizeof(__m512) + 2 * sizeof(__m256))));
+        __m256* pTemp256 = reinterpret_cast<__m256*>(pTemp512 + _diameter * 4);
 
         const int col64 = width - (width % SIMD_AVX512_SPP);
 
@@ -504,11 +506,18 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD
         pMem = g_pMem + y * width;
         pMemSum = g_pMemSum + y * width;
 
+        if (touch)
+        {
+            std::fill_n(pMem, width, 0);
+            std::fill_n(pMemSum, width, std::numeric_limits<float>::max());
+        }
+
         for (int x{ 0 }; x < col64; x += SIMD_AVX512_SPP)
         {
             // copy all input frames processed samples in SIMD pass in the temp buf in float32 form
-            for (int i = 0; i < (_maxr * 2 + 1); i++)
+            for (int ws = 0; ws < win.num; ws++)
             {
+                const int i = win.slot[ws];
                 float* data_ptr;
                 if (i == _maxr) // src sample
                 {
@@ -548,15 +557,17 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD
             __m512i zmm_idx_minrow_h16_2 = _mm512_setzero_si512();
 
 
-            for (int dmt_row = 0; dmt_row < (_maxr * 2 + 1); dmt_row++)
+            for (int wr = 0; wr < win.num; wr++)
             {
+                const int dmt_row = win.slot[wr];
                 __m512 zmm_sum_row_l16_1 = _mm512_setzero_ps();
                 __m512 zmm_sum_row_l16_2 = _mm512_setzero_ps();
                 __m512 zmm_sum_row_h16_1 = _mm512_setzero_ps();
                 __m512 zmm_sum_row_h16_2 = _mm512_setzero_ps();
 
-                for (int dmt_col = 0; dmt_col < (_maxr * 2 + 1); dmt_col++)
+                for (int wc = 0; wc < win.num; wc++)
                 {
+                    const int dmt_col = win.slot[wc];
                     if (dmt_row == dmt_col)
                     { // samples with itselves => DM=0
                         continue;
@@ -584,6 +595,16 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD
                     __m512 zmm_abs_h16_1 = _mm512_andnot_ps(sign_bit, zmm_subtr_h16_1);
                     __m512 zmm_abs_h16_2 = _mm512_andnot_ps(sign_bit, zmm_subtr_h16_2);
 
+                    // copies of a clamped edge frame
+                    if (win.mult[wc] > 1)
+                    {
+                        const __m512 zmm_mult = _mm512_set1_ps(static_cast<float>(win.mult[wc]));
+                        zmm_abs_l16_1 = _mm512_mul_ps(zmm_abs_l16_1, zmm_mult);
+                        zmm_abs_l16_2 = _mm512_mul_ps(zmm_abs_l16_2, zmm_mult);
+                        zmm_abs_h16_1 = _mm512_mul_ps(zmm_abs_h16_1, zmm_mult);
+                        zmm_abs_h16_2 = _mm512_mul_ps(zmm_abs_h16_2, zmm_mult);
+                    }
+
                     zmm_sum_row_l16_1 = _mm512_add_ps(zmm_sum_row_l16_1, zmm_abs_l16_1);
                     zmm_sum_row_l16_2 = _mm512_add_ps(zmm_sum_row_l16_2, zmm_abs_l16_2);
                     zmm_sum_row_h16_1 = _mm512_add_ps(zmm_sum_row_h16_1, zmm_abs_h16_1);
@@ -771,8 +792,9 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD
         for (int x{ col64 }; x < width; x += 16)
         {
             // copy all input frames processed samples in SIMD pass in the temp buf in float32 form
-            for (int i = 0; i < (_maxr * 2 + 1); i++)
+            for (int ws = 0; ws < win.num; ws++)
             {
+                const int i = win.slot[ws];
                 float* data_ptr;
                 if (i == _maxr) // src sample
                 {
@@ -803,13 +825,15 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD
             __m256i ymm_idx_minrow_l8_2 = _mm256_setzero_si256();
 
 
-            for (int dmt_row = 0; dmt_row < (_maxr * 2 + 1); dmt_row++)
+            for (int wr = 0; wr < win.num; wr++)
             {
+                const int dmt_row = win.slot[wr];
                 __m256 ymm_sum_row_l8_1 = _mm256_setzero_ps();
                 __m256 ymm_sum_row_l8_2 = _mm256_setzero_ps();
 
-                for (int dmt_col = 0; dmt_col < (_maxr * 2 + 1); dmt_col++)
+                for (int wc = 0; wc < win.num; wc++)
                 {
+                    const int dmt_col = win.slot[wc];
                     if (dmt_row == dmt_col)
                     { // samples with itselves => DM=0
                         continue;
@@ -829,6 +853,14 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD
                     __m256 ymm_abs_l8_1 = _mm256_andnot_ps(sign_bit_256, ymm_subtr_l8_1);
                     __m256 ymm_abs_l8_2 = _mm256_andnot_ps(sign_bit_256, ymm_subtr_l8_2);
 
+                    // copies of a clamped edge frame
+                    if (win.mult[wc] > 1)
+                    {
+                        const __m256 ymm_mult = _mm256_set1_ps(static_cast<float>(win.mult[wc]));
+                        ymm_abs_l8_1 = _mm256_mul_ps(ymm_abs_l8_1, ymm_mult);
+                        ymm_abs_l8_2 = _mm256_mul_ps(ymm_abs_l8_2, ymm_mult);
+                    }
+
                     ymm_sum_row_l8_1 = _mm256_add_ps(ymm_sum_row_l8_1, ymm_abs_l8_1);
                     ymm_sum_row_l8_2 = _mm256_add_ps(ymm_sum_row_l8_2, ymm_abs_l8_2);
 
@@ -944,7 +976,7 @@ void TTempSmooth<pfclip, fp>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD
 
 }
 
-template void TTempSmooth<true, true>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<true, false>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<false, true>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
-template void TTempSmooth<false, false>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane);
+template void TTempSmooth<true, true>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<true, false>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<false, true>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);
+template void TTempSmooth<false, false>::filterF_mode2_avx512(PVideoFrame src[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame pf[(MAX_TEMP_RAD * 2 + 1)], PVideoFrame& dst, const int fromFrame, const int toFrame, const int plane, const window_slots& win);